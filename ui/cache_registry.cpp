@@ -0,0 +1,200 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/cache_registry.h"
+
+#include "base/flat_map.h"
+#include "base/flat_set.h"
+
+#include <crl/crl_on_main.h>
+
+namespace Ui {
+namespace {
+
+auto Caches = base::flat_map<uint64, CacheDescriptor>();
+auto CachesAutoincrement = uint64();
+auto UseTick = uint64();
+auto Budget = kDefaultCachesBudget;
+auto CheckScheduled = false;
+auto Reported = base::flat_map<std::atomic<int64>*, rpl::lifetime>();
+
+[[nodiscard]] int64 TotalBytes() {
+	auto result = int64();
+	for (const auto &[id, cache] : Caches) {
+		result += cache.bytes();
+	}
+	return result;
+}
+
+void CheckBudget() {
+	CheckScheduled = false;
+	if (!Budget) {
+		return;
+	}
+	auto total = TotalBytes();
+	auto skip = base::flat_set<uint64>();
+	while (total > Budget) {
+		// Evict from the cache with the least recently used entry,
+		// until its entries become newer than ones in other caches.
+		auto oldest = std::pair<uint64, uint64>();
+		auto next = std::numeric_limits<uint64>::max();
+		for (const auto &[id, cache] : Caches) {
+			if (skip.contains(id)) {
+				continue;
+			}
+			const auto used = cache.oldestUse();
+			if (!used) {
+				continue;
+			} else if (!oldest.first || used < oldest.first) {
+				if (oldest.first) {
+					next = oldest.first;
+				}
+				oldest = { used, id };
+			} else if (used < next) {
+				next = used;
+			}
+		}
+		if (!oldest.first) {
+			break;
+		}
+		const auto evict = Caches[oldest.second].evict;
+		const auto freed = evict(total - Budget, next);
+		if (freed <= 0) {
+			skip.emplace(oldest.second);
+		}
+		total -= freed;
+	}
+}
+
+} // namespace
+
+rpl::lifetime RegisterCache(CacheDescriptor &&descriptor) {
+	Expects(descriptor.bytes != nullptr);
+	Expects(descriptor.oldestUse != nullptr);
+	Expects(descriptor.evict != nullptr);
+	Expects(descriptor.trim != nullptr);
+
+	const auto id = ++CachesAutoincrement;
+	Caches.emplace(id, std::move(descriptor));
+	return rpl::lifetime([=] {
+		Caches.remove(id);
+	});
+}
+
+uint64 NextCacheUseTick() {
+	return ++UseTick;
+}
+
+void CacheGrown() {
+	if (!Budget || CheckScheduled) {
+		return;
+	}
+	CheckScheduled = true;
+	crl::on_main(CheckBudget);
+}
+
+void SetCachesBudget(int64 bytes) {
+	Expects(bytes >= 0);
+
+	if (Budget == bytes) {
+		return;
+	}
+	Budget = bytes;
+	CheckBudget();
+}
+
+int64 CachesBudget() {
+	return Budget;
+}
+
+std::vector<CacheUsage> CachesUsage() {
+	auto result = std::vector<CacheUsage>();
+	for (const auto &[id, cache] : Caches) {
+		const auto i = ranges::find(result, cache.name, &CacheUsage::name);
+		auto &usage = (i != end(result))
+			? *i
+			: result.emplace_back(CacheUsage{ .name = cache.name });
+		usage.bytes += cache.bytes();
+		++usage.caches;
+	}
+	ranges::sort(result, ranges::greater(), &CacheUsage::bytes);
+	return result;
+}
+
+void RegisterReportedCache(
+		const QString &name,
+		not_null<std::atomic<int64>*> total) {
+	if (Reported.contains(total)) {
+		return;
+	}
+	const auto raw = total.get();
+	Reported.emplace(raw, RegisterCache({
+		.name = name,
+		.bytes = [=] { return raw->load(); },
+		.oldestUse = [] { return uint64(); },
+		.evict = [](int64, uint64) { return int64(); },
+		.trim = [](CacheTrimLevel) {},
+	}));
+}
+
+ReportedCacheBytes::ReportedCacheBytes(not_null<std::atomic<int64>*> total)
+: _total(total) {
+}
+
+ReportedCacheBytes::ReportedCacheBytes(const ReportedCacheBytes &other)
+: _total(other._total) {
+	set(other._bytes);
+}
+
+ReportedCacheBytes::ReportedCacheBytes(ReportedCacheBytes &&other) noexcept
+: _total(base::take(other._total))
+, _bytes(base::take(other._bytes)) {
+}
+
+ReportedCacheBytes &ReportedCacheBytes::operator=(
+		const ReportedCacheBytes &other) {
+	if (this != &other) {
+		set(0);
+		_total = other._total;
+		set(other._bytes);
+	}
+	return *this;
+}
+
+ReportedCacheBytes &ReportedCacheBytes::operator=(
+		ReportedCacheBytes &&other) noexcept {
+	if (this != &other) {
+		set(0);
+		_total = base::take(other._total);
+		_bytes = base::take(other._bytes);
+	}
+	return *this;
+}
+
+ReportedCacheBytes::~ReportedCacheBytes() {
+	set(0);
+}
+
+void ReportedCacheBytes::set(int64 bytes) {
+	if (_total && _bytes != bytes) {
+		*_total += (bytes - _bytes);
+	}
+	_bytes = bytes;
+}
+
+void TrimCaches(CacheTrimLevel level) {
+	// Copy the callbacks, a cache may unregister others while trimming.
+	auto callbacks = std::vector<Fn<void(CacheTrimLevel)>>();
+	callbacks.reserve(Caches.size());
+	for (const auto &[id, cache] : Caches) {
+		callbacks.push_back(cache.trim);
+	}
+	for (const auto &callback : callbacks) {
+		callback(level);
+	}
+}
+
+} // namespace Ui
@@ -0,0 +1,122 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "base/basic_types.h"
+
+#include <rpl/lifetime.h>
+
+#include <atomic>
+
+namespace Ui {
+
+inline constexpr auto kDefaultCachesBudget = int64(128 * 1024 * 1024);
+
+enum class CacheTrimLevel {
+	Moderate, // Drop entries that were not used recently.
+	Critical, // Drop everything that can be recreated.
+};
+
+// Image caches enroll here to report their size and to be evicted
+// in least recently used order when the total budget is exceeded.
+//
+// All methods are main thread only. Usage ticks come from
+// NextCacheUseTick(), so that entries of different caches are comparable.
+struct CacheDescriptor {
+	QString name;
+
+	// Total bytes held by the cache right now.
+	Fn<int64()> bytes;
+
+	// Use tick of the least recently used entry, zero if none evictable.
+	Fn<uint64()> oldestUse;
+
+	// Evict least recently used entries till at least 'bytes' are freed,
+	// but not the ones used after 'tillUse'. Returns freed bytes.
+	Fn<int64(int64 bytes, uint64 tillUse)> evict;
+
+	Fn<void(CacheTrimLevel)> trim;
+};
+
+struct CacheUsage {
+	QString name;
+	int64 bytes = 0;
+	int caches = 0;
+};
+
+[[nodiscard]] rpl::lifetime RegisterCache(CacheDescriptor &&descriptor);
+[[nodiscard]] uint64 NextCacheUseTick();
+
+// Caches should call it after adding entries, budget is checked later.
+void CacheGrown();
+
+// Zero budget means no limit, kDefaultCachesBudget is used by default.
+void SetCachesBudget(int64 bytes);
+[[nodiscard]] int64 CachesBudget();
+[[nodiscard]] std::vector<CacheUsage> CachesUsage();
+void TrimCaches(CacheTrimLevel level);
+
+// Images owned by widgets and other objects are needed for painting and
+// can't be evicted, so their bytes are only reported in the caches usage.
+// The bytes may be changed from any thread, registering is main thread only.
+void RegisterReportedCache(
+	const QString &name,
+	not_null<std::atomic<int64>*> total);
+
+class ReportedCacheBytes final {
+public:
+	ReportedCacheBytes() = default;
+	explicit ReportedCacheBytes(not_null<std::atomic<int64>*> total);
+	ReportedCacheBytes(const ReportedCacheBytes &other);
+	ReportedCacheBytes(ReportedCacheBytes &&other) noexcept;
+	ReportedCacheBytes &operator=(const ReportedCacheBytes &other);
+	ReportedCacheBytes &operator=(ReportedCacheBytes &&other) noexcept;
+	~ReportedCacheBytes();
+
+	void set(int64 bytes);
+
+private:
+	std::atomic<int64> *_total = nullptr;
+	int64 _bytes = 0;
+
+};
+
+// Helpers for map caches with values having a 'used' tick field.
+template <typename Map>
+[[nodiscard]] uint64 OldestCacheUse(const Map &map) {
+	auto result = uint64();
+	for (const auto &[key, value] : map) {
+		if (!result || value.used < result) {
+			result = value.used;
+		}
+	}
+	return result;
+}
+
+template <typename Map, typename Size>
+int64 EvictLeastUsed(Map &map, int64 bytes, uint64 tillUse, Size &&size) {
+	using Key = typename Map::key_type;
+	auto candidates = std::vector<std::pair<uint64, Key>>();
+	for (const auto &[key, value] : map) {
+		if (value.used <= tillUse) {
+			candidates.emplace_back(value.used, key);
+		}
+	}
+	ranges::sort(candidates);
+	auto result = int64();
+	for (const auto &[used, key] : candidates) {
+		if (result >= bytes) {
+			break;
+		}
+		const auto i = map.find(key);
+		result += size(i->second);
+		map.erase(i);
+	}
+	return result;
+}
+
+} // namespace Ui
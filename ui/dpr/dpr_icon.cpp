@@ -6,9 +6,174 @@
 //
 #include "ui/dpr/dpr_icon.h"
 
+#include "ui/cache_registry.h"
+
 namespace dpr {
+namespace {
 
-QImage IconFrame(
+// Frames are usually painted in a few places only, keep them bounded
+// even when the global caches budget is not reached.
+constexpr auto kMaxIconFrames = 48;
+constexpr auto kMaxIconFramesBytes = int64(4 * 1024 * 1024);
+
+struct IconFrameKey {
+	uint64 icon = 0;
+	QRgb color = 0;
+	double ratio = 0.;
+	int scale = 0;
+	int devicePixelRatio = 0;
+
+	friend inline auto operator<=>(
+		const IconFrameKey &,
+		const IconFrameKey &) = default;
+};
+
+struct CachedIconFrame {
+	QImage image;
+	uint64 used = 0;
+};
+
+// Source pixels covered by each destination pixel with their weights.
+struct BoxTaps {
+	std::vector<int> offsets;
+	std::vector<int> indices;
+	std::vector<float> weights;
+};
+
+auto IconFrames = std::map<IconFrameKey, CachedIconFrame>();
+auto IconFramesBytes = int64();
+auto IconFramesCache = rpl::lifetime();
+auto IconFramesCacheRegistered = false;
+
+[[nodiscard]] int64 IconFrameSize(const CachedIconFrame &frame) {
+	return frame.image.sizeInBytes();
+}
+
+int64 EvictIconFrames(int64 bytes, uint64 tillUse) {
+	const auto result = Ui::EvictLeastUsed(
+		IconFrames,
+		bytes,
+		tillUse,
+		IconFrameSize);
+	IconFramesBytes -= result;
+	return result;
+}
+
+void MakeRoomForIconFrame(int64 bytes) {
+	if (IconFramesBytes + bytes > kMaxIconFramesBytes) {
+		EvictIconFrames(
+			IconFramesBytes + bytes - kMaxIconFramesBytes,
+			uint64(-1));
+	}
+	while (IconFrames.size() >= kMaxIconFrames) {
+		const auto i = ranges::min_element(
+			IconFrames,
+			ranges::less(),
+			[](const auto &pair) { return pair.second.used; });
+		IconFramesBytes -= IconFrameSize(i->second);
+		IconFrames.erase(i);
+	}
+}
+
+void RegisterIconFramesCache() {
+	if (IconFramesCacheRegistered) {
+		return;
+	}
+	IconFramesCacheRegistered = true;
+	IconFramesCache = Ui::RegisterCache({
+		.name = u"dpr icons"_q,
+		.bytes = [] { return IconFramesBytes; },
+		.oldestUse = [] { return Ui::OldestCacheUse(IconFrames); },
+		.evict = EvictIconFrames,
+		.trim = [](Ui::CacheTrimLevel) {
+			IconFrames.clear();
+			IconFramesBytes = 0;
+		},
+	});
+}
+
+[[nodiscard]] BoxTaps ComputeBoxTaps(int from, int to) {
+	Expects(to > 0 && from >= to);
+
+	const auto step = from / double(to);
+	auto result = BoxTaps();
+	result.offsets.reserve(to + 1);
+	result.indices.reserve(from + to);
+	result.weights.reserve(from + to);
+	for (auto i = 0; i != to; ++i) {
+		result.offsets.push_back(int(result.indices.size()));
+		const auto left = i * step;
+		const auto right = std::min((i + 1) * step, double(from));
+		for (auto j = int(left); j < from && j < right; ++j) {
+			const auto weight = std::min(right, j + 1.)
+				- std::max(left, double(j));
+			if (weight > 0.) {
+				result.indices.push_back(j);
+				result.weights.push_back(float(weight / step));
+			}
+		}
+	}
+	result.offsets.push_back(int(result.indices.size()));
+	return result;
+}
+
+// Averages premultiplied pixels over the area each target pixel covers.
+[[nodiscard]] QImage BoxDownscale(const QImage &image, QSize size) {
+	Expects(image.format() == QImage::Format_ARGB32_Premultiplied);
+	Expects(!size.isEmpty());
+	Expects(image.width() >= size.width());
+	Expects(image.height() >= size.height());
+
+	const auto horizontal = ComputeBoxTaps(image.width(), size.width());
+	const auto vertical = ComputeBoxTaps(image.height(), size.height());
+
+	// Horizontal pass, four float channels for each intermediate pixel.
+	const auto width = size.width();
+	auto columns = std::vector<float>(width * image.height() * 4);
+	for (auto y = 0; y != image.height(); ++y) {
+		const auto line = reinterpret_cast<const uchar*>(
+			image.constScanLine(y));
+		auto out = columns.data() + y * width * 4;
+		for (auto x = 0; x != width; ++x) {
+			auto sums = std::array<float, 4>{};
+			const auto till = horizontal.offsets[x + 1];
+			for (auto k = horizontal.offsets[x]; k != till; ++k) {
+				const auto pixel = line + horizontal.indices[k] * 4;
+				const auto weight = horizontal.weights[k];
+				for (auto c = 0; c != 4; ++c) {
+					sums[c] += pixel[c] * weight;
+				}
+			}
+			std::copy(begin(sums), end(sums), out + x * 4);
+		}
+	}
+
+	auto result = QImage(size, QImage::Format_ARGB32_Premultiplied);
+	for (auto y = 0; y != size.height(); ++y) {
+		auto line = result.scanLine(y);
+		const auto till = vertical.offsets[y + 1];
+		for (auto x = 0; x != width; ++x) {
+			auto sums = std::array<float, 4>{};
+			for (auto k = vertical.offsets[y]; k != till; ++k) {
+				const auto pixel = columns.data()
+					+ (vertical.indices[k] * width + x) * 4;
+				const auto weight = vertical.weights[k];
+				for (auto c = 0; c != 4; ++c) {
+					sums[c] += pixel[c] * weight;
+				}
+			}
+			for (auto c = 0; c != 4; ++c) {
+				line[x * 4 + c] = uchar(std::clamp(
+					int(sums[c] + 0.5f),
+					0,
+					255));
+			}
+		}
+	}
+	return result;
+}
+
+[[nodiscard]] QImage RenderIconFrame(
 		const style::icon &icon,
 		const QColor &color,
 		double ratio) {
@@ -21,12 +186,50 @@ QImage IconFrame(
 	auto image = icon.instance(color, use);
 	image.setDevicePixelRatio(1.);
 	const auto desired = icon.size() * ratio;
-	return (image.size() == desired)
-		? image
-		: image.scaled(
+	if (image.size() == desired || desired.isEmpty()) {
+		return image;
+	} else if (image.width() < desired.width()
+		|| image.height() < desired.height()
+		|| image.format() != QImage::Format_ARGB32_Premultiplied) {
+		return image.scaled(
 			desired,
 			Qt::IgnoreAspectRatio,
 			Qt::SmoothTransformation);
+	}
+	return BoxDownscale(image, desired);
+}
+
+} // namespace
+
+QImage IconFrame(
+		const style::icon &icon,
+		const QColor &color,
+		double ratio) {
+	const auto key = IconFrameKey{
+		.icon = icon.cacheKey(),
+		.color = color.rgba(),
+		.ratio = ratio,
+		.scale = style::Scale(),
+		.devicePixelRatio = style::DevicePixelRatio(),
+	};
+	const auto i = IconFrames.find(key);
+	if (i != end(IconFrames)) {
+		i->second.used = Ui::NextCacheUseTick();
+		return i->second.image;
+	}
+	auto image = RenderIconFrame(icon, color, ratio);
+	if (image.isNull()) {
+		return image;
+	}
+	RegisterIconFramesCache();
+	MakeRoomForIconFrame(image.sizeInBytes());
+	const auto j = IconFrames.emplace(key, CachedIconFrame{
+		.image = std::move(image),
+		.used = Ui::NextCacheUseTick(),
+	}).first;
+	IconFramesBytes += IconFrameSize(j->second);
+	Ui::CacheGrown();
+	return j->second.image;
 }
 
 } // namespace dpr
@@ -6,34 +6,58 @@
 //
 #include "ui/dragging_scroll_manager.h"
 
-#include "base/timer.h"
-
 namespace Ui {
 namespace {
 
-// 37px per 15ms while select-by-drag.
-inline constexpr auto kMaxScrollSpeed = 37;
+// Pixels per second while select-by-drag, was 1px..37px per 15ms.
+constexpr auto kMinScrollSpeed = 1000. / 15.;
+constexpr auto kMaxScrollSpeed = 37. * 1000. / 15.;
+
+// Speed added for each pixel the cursor is outside of the scroll area.
+constexpr auto kScrollSpeedPerPixel = 3. / 20. * 1000. / 15.;
+
+// Don't jump too far if the main thread was blocked for a while.
+constexpr auto kMaxFrameDuration = crl::time(100);
 
 } // namespace
 
-DraggingScrollManager::DraggingScrollManager() = default;
+DraggingScrollManager::DraggingScrollManager()
+: _animation([=](crl::time now) { scrollByAnimation(now); }) {
+}
+
+float64 DraggingScrollManager::speed() const {
+	const auto result = std::min(
+		kMinScrollSpeed + std::abs(_delta) * kScrollSpeedPerPixel,
+		kMaxScrollSpeed);
+	return (_delta > 0) ? result : -result;
+}
+
+void DraggingScrollManager::scrollByAnimation(crl::time now) {
+	const auto elapsed = std::clamp(
+		now - _lastFrameTime,
+		crl::time(0),
+		kMaxFrameDuration);
+	_lastFrameTime = now;
+	_accumulated += speed() * elapsed / 1000.;
 
-void DraggingScrollManager::scrollByTimer() {
-	const auto d = (_delta > 0)
-		? std::min(_delta * 3 / 20 + 1, kMaxScrollSpeed)
-		: std::max(_delta * 3 / 20 - 1, -kMaxScrollSpeed);
-	_scrolls.fire_copy(d);
+	const auto d = int(_accumulated);
+	if (d) {
+		_accumulated -= d;
+		_scrolls.fire_copy(d);
+	}
 }
 
 void DraggingScrollManager::checkDeltaScroll(int delta) {
-	_delta = delta;
-	if (_delta) {
-		if (!_timer) {
-			_timer = std::make_unique<base::Timer>([=] { scrollByTimer(); });
-		}
-		_timer->callEach(15);
-	} else {
+	if (!delta) {
 		cancel();
+		return;
+	} else if ((_delta > 0) != (delta > 0)) {
+		_accumulated = 0.;
+	}
+	_delta = delta;
+	if (!_animation.animating()) {
+		_lastFrameTime = crl::now();
+		_animation.start();
 	}
 }
 
@@ -50,10 +74,9 @@ void DraggingScrollManager::checkDeltaScroll(
 }
 
 void DraggingScrollManager::cancel() {
-	if (_timer) {
-		_timer->cancel();
-		_timer = nullptr;
-	}
+	_animation.stop();
+	_accumulated = 0.;
+	_delta = 0;
 }
 
 rpl::producer<int> DraggingScrollManager::scrolls() const {
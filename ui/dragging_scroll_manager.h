@@ -6,9 +6,7 @@
 //
 #pragma once
 
-namespace base {
-class Timer;
-} // namespace base
+#include "ui/effects/animations.h"
 
 namespace Ui {
 
@@ -23,9 +21,12 @@ public:
 	[[nodiscard]] rpl::producer<int> scrolls() const;
 
 private:
-	void scrollByTimer();
+	[[nodiscard]] float64 speed() const;
+	void scrollByAnimation(crl::time now);
 
-	std::unique_ptr<base::Timer> _timer;
+	Animations::Basic _animation;
+	crl::time _lastFrameTime = 0;
+	float64 _accumulated = 0.;
 	int _delta = 0;
 	rpl::event_stream<int> _scrolls;
 
@@ -0,0 +1,110 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/dynamic_image.h"
+
+namespace Ui {
+namespace {
+
+class SharedDynamicImage final : public DynamicImage {
+public:
+	explicit SharedDynamicImage(std::shared_ptr<DynamicImageSource> source);
+	~SharedDynamicImage();
+
+	std::shared_ptr<DynamicImage> clone() override;
+
+	QImage image(int size) override;
+	void subscribeToUpdates(Fn<void()> callback) override;
+
+private:
+	const std::shared_ptr<DynamicImageSource> _source;
+
+};
+
+SharedDynamicImage::SharedDynamicImage(
+	std::shared_ptr<DynamicImageSource> source)
+: _source(std::move(source)) {
+	Expects(_source != nullptr);
+}
+
+SharedDynamicImage::~SharedDynamicImage() {
+	_source->subscribe(this, nullptr);
+}
+
+std::shared_ptr<DynamicImage> SharedDynamicImage::clone() {
+	return std::make_shared<SharedDynamicImage>(_source);
+}
+
+QImage SharedDynamicImage::image(int size) {
+	return _source->frame(size);
+}
+
+void SharedDynamicImage::subscribeToUpdates(Fn<void()> callback) {
+	_source->subscribe(this, std::move(callback));
+}
+
+} // namespace
+
+void DynamicImageSource::updated() {
+	// A callback may destroy the last clone and the source with it.
+	const auto guard = weak_from_this().lock();
+
+	_frames.clear();
+
+	// Callbacks may unsubscribe or destroy other clones,
+	// so each subscriber is looked up again before it is called.
+	auto subscribers = std::vector<not_null<const void*>>();
+	subscribers.reserve(_subscribers.size());
+	for (const auto &[subscriber, callback] : _subscribers) {
+		subscribers.push_back(subscriber);
+	}
+	for (const auto subscriber : subscribers) {
+		const auto i = _subscribers.find(subscriber);
+		if (i != end(_subscribers)) {
+			// The callback may unsubscribe itself, so call a copy.
+			const auto callback = i->second;
+			callback();
+		}
+	}
+}
+
+QImage DynamicImageSource::frame(int size) {
+	const auto i = _frames.find(size);
+	if (i != end(_frames)) {
+		return i->second;
+	}
+	auto result = render(size);
+	if (!_subscribers.empty()) {
+		// Keep frames only while someone can be told they are outdated.
+		_frames.emplace(size, result);
+	}
+	return result;
+}
+
+void DynamicImageSource::subscribe(
+		not_null<const void*> subscriber,
+		Fn<void()> callback) {
+	const auto was = !_subscribers.empty();
+	if (callback) {
+		_subscribers[subscriber] = std::move(callback);
+	} else {
+		_subscribers.remove(subscriber);
+	}
+	const auto now = !_subscribers.empty();
+	if (was != now) {
+		if (!now) {
+			_frames.clear();
+		}
+		subscribedChanged(now);
+	}
+}
+
+std::shared_ptr<DynamicImage> MakeSharedDynamicImage(
+		std::shared_ptr<DynamicImageSource> source) {
+	return std::make_shared<SharedDynamicImage>(std::move(source));
+}
+
+} // namespace Ui
@@ -6,6 +6,8 @@
 //
 #pragma once
 
+#include "base/flat_map.h"
+
 namespace Ui {
 
 class DynamicImage {
@@ -18,4 +20,34 @@ public:
 	virtual void subscribeToUpdates(Fn<void()> callback) = 0;
 };
 
+// Content shared by many DynamicImage clones, showing the same userpic
+// or emoji status in different places. Frames are rendered once for each
+// size and update notifications are sent to all the subscribed clones.
+class DynamicImageSource
+	: public std::enable_shared_from_this<DynamicImageSource> {
+public:
+	virtual ~DynamicImageSource() = default;
+
+	[[nodiscard]] virtual QImage render(int size) = 0;
+
+	// Called when the first clone subscribes and when the last one leaves,
+	// so that the source could start or stop tracking its content.
+	virtual void subscribedChanged(bool subscribed) {
+	}
+
+	// Drops the rendered frames and notifies all the subscribers.
+	void updated();
+
+	[[nodiscard]] QImage frame(int size);
+	void subscribe(not_null<const void*> subscriber, Fn<void()> callback);
+
+private:
+	base::flat_map<int, QImage> _frames;
+	base::flat_map<not_null<const void*>, Fn<void()>> _subscribers;
+
+};
+
+[[nodiscard]] std::shared_ptr<DynamicImage> MakeSharedDynamicImage(
+	std::shared_ptr<DynamicImageSource> source);
+
 } // namespace Ui
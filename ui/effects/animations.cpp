@@ -8,6 +8,7 @@
 
 #include "base/invoke_queued.h"
 #include "ui/ui_utility.h"
+#include "ui/stall_watchdog.h"
 #include "styles/style_basic.h"
 
 #include <QtCore/QPointer>
@@ -26,6 +27,14 @@ namespace {
 constexpr auto kAnimationTick = crl::time(1000) / st::universalDuration;
 constexpr auto kIgnoreUpdatesTimeout = crl::time(4);
 
+// Frames longer than that are pauses, not the main thread load.
+constexpr auto kMaxMeasuredFrame = crl::time(250);
+constexpr auto kOverloadedFrame = kAnimationTick * 5 / 2;
+constexpr auto kRelaxedFrame = kAnimationTick * 3 / 2;
+constexpr auto kThrottleRaiseDelay = crl::time(500);
+constexpr auto kThrottleLowerDelay = crl::time(1000);
+constexpr auto kMaxThrottleLevel = 3;
+
 Manager *ManagerInstance = nullptr;
 bool ScheduleWithInvokeQueued = false;
 
@@ -134,10 +143,25 @@ void Manager::update() {
 
 	_updating = true;
 	const auto guard = gsl::finally([&] { _updating = false; });
+	const auto watch = StallScope(StallCategory::Animations);
 
+	measureFrame(now);
 	_lastUpdateTime = now;
+	const auto interactive = throttleDivider(Priority::Interactive);
+	const auto normal = throttleDivider(Priority::Normal);
+	const auto decorative = throttleDivider(Priority::Decorative);
 	const auto isFinished = [&](const ActiveBasicPointer &element) {
-		return !element.call(now);
+		const auto value = element.get();
+		if (!value) {
+			return true;
+		}
+		const auto priority = value->priority();
+		const auto divider = (priority == Priority::Interactive)
+			? interactive
+			: (priority == Priority::Normal)
+			? normal
+			: decorative;
+		return !element.throttled(divider) && !element.call(now);
 	};
 	_active.erase(ranges::remove_if(_active, isFinished), end(_active));
 
@@ -156,6 +180,39 @@ void Manager::update() {
 	}
 }
 
+void Manager::measureFrame(crl::time now) {
+	const auto frame = now - _lastUpdateTime;
+	if (!_lastUpdateTime || frame > kMaxMeasuredFrame) {
+		return;
+	}
+	_frameDuration = _frameDuration
+		? (_frameDuration * 7 + frame) / 8.
+		: float64(frame);
+	if (_frameDuration > kOverloadedFrame
+		&& _throttleLevel < kMaxThrottleLevel
+		&& now - _throttleChanged >= kThrottleRaiseDelay) {
+		++_throttleLevel;
+		_throttleChanged = now;
+	} else if (_frameDuration < kRelaxedFrame
+		&& _throttleLevel > 0
+		&& now - _throttleChanged >= kThrottleLowerDelay) {
+		--_throttleLevel;
+		_throttleChanged = now;
+	}
+}
+
+int Manager::throttleDivider(Priority priority) const {
+	// Decorative animations get two and four times less frequent ticks
+	// on the first two levels, normal ones join them on the third one.
+	switch (priority) {
+	case Priority::Interactive: return 1;
+	case Priority::Normal: return (_throttleLevel >= 3) ? 2 : 1;
+	case Priority::Decorative:
+		return (_throttleLevel >= 2) ? 4 : (_throttleLevel == 1) ? 2 : 1;
+	}
+	Unexpected("Priority in Manager::throttleDivider.");
+}
+
 void Manager::updateQueued() {
 	Expects(_timerId == 0);
 
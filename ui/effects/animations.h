@@ -17,6 +17,14 @@ namespace Animations {
 
 class Manager;
 
+// When the main thread can't keep up with the frame rate, the manager
+// ticks decorative animations less often first, then normal ones.
+enum class Priority : uchar {
+	Interactive,
+	Normal,
+	Decorative,
+};
+
 class Basic final {
 public:
 	Basic() = default;
@@ -34,6 +42,9 @@ public:
 	void start();
 	void stop();
 
+	void setPriority(Priority priority);
+	[[nodiscard]] Priority priority() const;
+
 	[[nodiscard]] crl::time started() const;
 	[[nodiscard]] bool animating() const;
 
@@ -53,6 +64,7 @@ private:
 
 	crl::time _started = -1;
 	Fn<bool(crl::time)> _callback;
+	Priority _priority = Priority::Normal;
 
 };
 
@@ -73,6 +85,10 @@ public:
 		anim::transition transition = anim::linear);
 	void stop();
 	void setFinishedCallback(Fn<void()> callback);
+
+	// Applies to the running animation, so call it after start().
+	void setPriority(Priority priority);
+
 	[[nodiscard]] bool animating() const;
 	[[nodiscard]] float64 value(float64 final) const;
 
@@ -154,13 +170,17 @@ public:
 private:
 	class ActiveBasicPointer {
 	public:
+		// Just started animations are called on the first tick.
+		static constexpr auto kNotCalledYet = 1 << 16;
+
 		ActiveBasicPointer(Basic *value = nullptr) : _value(value) {
 			if (_value) {
 				_value->markStarted();
 			}
 		}
 		ActiveBasicPointer(ActiveBasicPointer &&other)
-		: _value(base::take(other._value)) {
+		: _value(base::take(other._value))
+		, _skipped(other._skipped) {
 		}
 		ActiveBasicPointer &operator=(ActiveBasicPointer &&other) {
 			if (_value != other._value) {
@@ -168,6 +188,7 @@ private:
 					_value->markStopped();
 				}
 				_value = base::take(other._value);
+				_skipped = other._skipped;
 			}
 			return *this;
 		}
@@ -181,6 +202,17 @@ private:
 			return _value && _value->call(now);
 		}
 
+		// Returns true if this tick should be skipped, so that
+		// the animation is called only on each 'divider'-th tick.
+		[[nodiscard]] bool throttled(int divider) const {
+			if (_skipped + 1 >= divider) {
+				_skipped = 0;
+				return false;
+			}
+			++_skipped;
+			return true;
+		}
+
 		friend inline bool operator==(
 				const ActiveBasicPointer &a,
 				const ActiveBasicPointer &b) {
@@ -193,6 +225,7 @@ private:
 
 	private:
 		Basic *_value = nullptr;
+		mutable int _skipped = kNotCalledYet;
 
 	};
 
@@ -208,7 +241,13 @@ private:
 	void stopTimer();
 	not_null<const QObject*> delayedCallGuard() const;
 
+	void measureFrame(crl::time now);
+	[[nodiscard]] int throttleDivider(Priority priority) const;
+
 	crl::time _lastUpdateTime = 0;
+	crl::time _throttleChanged = 0;
+	float64 _frameDuration = 0.;
+	int _throttleLevel = 0;
 	int _timerId = 0;
 	bool _updating = false;
 	bool _removedWhileUpdating = false;
@@ -274,6 +313,14 @@ inline void Basic::init(Callback &&callback) {
 	_callback = Prepare(std::forward<Callback>(callback));
 }
 
+inline void Basic::setPriority(Priority priority) {
+	_priority = priority;
+}
+
+inline Priority Basic::priority() const {
+	return _priority;
+}
+
 TG_FORCE_INLINE crl::time Basic::started() const {
 	return _started;
 }
@@ -290,7 +337,9 @@ TG_FORCE_INLINE bool Basic::call(crl::time now) const {
 	return onstack(std::max(_started, now));
 }
 
-inline Basic::Basic(Basic &&other) : _callback(base::take(other._callback)) {
+inline Basic::Basic(Basic &&other)
+: _callback(base::take(other._callback))
+, _priority(other._priority) {
 	if (other.animating()) {
 		const auto started = other._started;
 		other.stop();
@@ -301,6 +350,7 @@ inline Basic::Basic(Basic &&other) : _callback(base::take(other._callback)) {
 
 inline Basic &Basic::operator=(Basic &&other) {
 	_callback = base::take(other._callback);
+	_priority = other._priority;
 	if (animating()) {
 		stop();
 	}
@@ -445,6 +495,12 @@ inline void Simple::setFinishedCallback(Fn<void()> callback) {
 	}
 }
 
+inline void Simple::setPriority(Priority priority) {
+	if (_data) {
+		_data->animation.setPriority(priority);
+	}
+}
+
 inline void Simple::stop() {
 	_data = nullptr;
 }
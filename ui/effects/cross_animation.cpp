@@ -7,6 +7,7 @@
 #include "ui/effects/cross_animation.h"
 
 #include "ui/effects/animation_value.h"
+#include "ui/effects/keyframe_cache.h"
 #include "ui/arc_angles.h"
 #include "ui/painter.h"
 
@@ -18,6 +19,8 @@ namespace {
 
 constexpr auto kPointCount = 12;
 constexpr auto kStaticLoadingValue = float64(-666);
+constexpr auto kShownKeyframes = 64;
+constexpr auto kLoadingKeyframes = 128;
 
 
 //
@@ -96,20 +99,7 @@ void transformLoadingCross(float64 loading, std::array<QPointF, kPointCount> &po
 	}
 }
 
-} // namespace
-
-void CrossAnimation::paintStaticLoading(
-		QPainter &p,
-		const style::CrossAnimation &st,
-		style::color color,
-		int x,
-		int y,
-		int outerWidth,
-		float64 shown) {
-	paint(p, st, color, x, y, outerWidth, shown, kStaticLoadingValue);
-}
-
-void CrossAnimation::paint(
+void PaintDirect(
 		QPainter &p,
 		const style::CrossAnimation &st,
 		style::color color,
@@ -203,4 +193,75 @@ void CrossAnimation::paint(
 	}
 }
 
+} // namespace
+
+void CrossAnimation::paintStaticLoading(
+		QPainter &p,
+		const style::CrossAnimation &st,
+		style::color color,
+		int x,
+		int y,
+		int outerWidth,
+		float64 shown) {
+	paint(p, st, color, x, y, outerWidth, shown, kStaticLoadingValue);
+}
+
+void CrossAnimation::paint(
+		QPainter &p,
+		const style::CrossAnimation &st,
+		style::color color,
+		int x,
+		int y,
+		int outerWidth,
+		float64 shown,
+		float64 loading) {
+	// Either hiding / showing or loading frames are shared between
+	// all the crosses of the same style and color, other states are
+	// rare enough to be painted directly.
+	const auto shownOnly = (loading == 0.);
+	const auto loadingOnly = (loading > 0.) && (shown == 1.);
+	const auto ratio = style::DevicePixelRatio();
+	if ((!shownOnly && !loadingOnly)
+		|| style::RightToLeft()
+		|| p.transform().type() > QTransform::TxTranslate
+		|| float64(p.device()->devicePixelRatio()) != ratio) {
+		PaintDirect(p, st, color, x, y, outerWidth, shown, loading);
+		return;
+	}
+	const auto stroke = style::ConvertScaleExact(st.stroke);
+	const auto margin = int(std::ceil(stroke)) + 1;
+	const auto size = st.size + 2 * margin;
+	const auto fixed = [](float64 value) {
+		return uint64(uint32(int(base::SafeRound(value * 65536))));
+	};
+	const auto frame = Keyframe({
+		.style = (uint64(uint32(st.size)) << 32) | uint32(st.skip),
+		.variant = (fixed(st.stroke) << 32) | fixed(st.minScale),
+		.extra = (uint64(color->c.rgba()) << 1) | (loadingOnly ? 1 : 0),
+		.width = size,
+		.height = size,
+		.ratio = ratio,
+	}, shownOnly ? shown : loading, [&](float64 progress) {
+		auto result = QImage(
+			QSize(size, size) * ratio,
+			QImage::Format_ARGB32_Premultiplied);
+		result.setDevicePixelRatio(ratio);
+		result.fill(Qt::transparent);
+		{
+			auto q = QPainter(&result);
+			PaintDirect(
+				q,
+				st,
+				color,
+				margin,
+				margin,
+				size,
+				shownOnly ? progress : 1.,
+				shownOnly ? 0. : progress);
+		}
+		return result;
+	}, shownOnly ? kShownKeyframes : kLoadingKeyframes);
+	p.drawImage(x - margin, y - margin, frame);
+}
+
 } // namespace Ui
@@ -0,0 +1,97 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/effects/keyframe_cache.h"
+
+#include "ui/cache_registry.h"
+#include "ui/style/style_core.h"
+
+namespace Ui {
+namespace {
+
+struct CachedKeyframe {
+	QImage image;
+	uint64 used = 0;
+};
+
+using KeyframeIndex = std::pair<KeyframeKey, int>;
+
+auto Keyframes = std::map<KeyframeIndex, CachedKeyframe>();
+auto KeyframesBytes = int64();
+auto KeyframesCache = rpl::lifetime();
+auto KeyframesCacheRegistered = false;
+auto KeyframesPaletteVersion = 0;
+
+[[nodiscard]] int64 KeyframeSize(const CachedKeyframe &frame) {
+	return frame.image.sizeInBytes();
+}
+
+void RegisterKeyframesCache() {
+	if (KeyframesCacheRegistered) {
+		return;
+	}
+	KeyframesCacheRegistered = true;
+	KeyframesCache = RegisterCache({
+		.name = u"keyframes"_q,
+		.bytes = [] { return KeyframesBytes; },
+		.oldestUse = [] { return OldestCacheUse(Keyframes); },
+		.evict = [](int64 bytes, uint64 tillUse) {
+			const auto result = EvictLeastUsed(
+				Keyframes,
+				bytes,
+				tillUse,
+				KeyframeSize);
+			KeyframesBytes -= result;
+			return result;
+		},
+		.trim = [](CacheTrimLevel) {
+			Keyframes.clear();
+			KeyframesBytes = 0;
+		},
+	});
+}
+
+} // namespace
+
+QImage Keyframe(
+		const KeyframeKey &key,
+		float64 progress,
+		FnMut<QImage(float64 progress)> render,
+		int count) {
+	Expects(count > 0);
+
+	// Frames may be rendered with palette colors,
+	// so all of them are dropped when the palette changes.
+	const auto paletteVersion = style::PaletteVersion();
+	if (KeyframesPaletteVersion != paletteVersion) {
+		KeyframesPaletteVersion = paletteVersion;
+		Keyframes.clear();
+		KeyframesBytes = 0;
+	}
+
+	const auto index = int(base::SafeRound(
+		std::clamp(progress, 0., 1.) * count));
+	const auto full = KeyframeIndex{ key, index };
+	const auto i = Keyframes.find(full);
+	if (i != end(Keyframes)) {
+		i->second.used = NextCacheUseTick();
+		return i->second.image;
+	}
+	auto image = render(index / float64(count));
+	if (image.isNull()) {
+		return image;
+	}
+	RegisterKeyframesCache();
+	const auto j = Keyframes.emplace(full, CachedKeyframe{
+		.image = std::move(image),
+		.used = NextCacheUseTick(),
+	}).first;
+	KeyframesBytes += KeyframeSize(j->second);
+	CacheGrown();
+	return j->second.image;
+}
+
+} // namespace Ui
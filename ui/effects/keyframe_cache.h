@@ -0,0 +1,43 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "base/basic_types.h"
+
+namespace Ui {
+
+inline constexpr auto kDefaultKeyframesCount = 64;
+
+// Identifies a deterministic morph animation, frames of which are shared
+// by all the widgets drawing the same thing. The fields hold stable ids,
+// like Icon::cacheKey(), or the drawn parameters themselves, never
+// addresses: a style may be destroyed and another one created in place.
+struct KeyframeKey {
+	uint64 style = 0;
+	uint64 variant = 0;
+	uint64 extra = 0;
+	int width = 0;
+	int height = 0;
+	int ratio = 0;
+
+	friend inline auto operator<=>(
+		const KeyframeKey &,
+		const KeyframeKey &) = default;
+	friend inline bool operator==(
+		const KeyframeKey &,
+		const KeyframeKey &) = default;
+};
+
+// Returns the frame for 'progress' rounded to 1 / 'count' steps,
+// calling 'render' with the rounded progress if it is not cached yet.
+[[nodiscard]] QImage Keyframe(
+	const KeyframeKey &key,
+	float64 progress,
+	FnMut<QImage(float64 progress)> render,
+	int count = kDefaultKeyframesCount);
+
+} // namespace Ui
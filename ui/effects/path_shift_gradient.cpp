@@ -158,6 +158,7 @@ void PathShiftGradient::activateAnimation() {
 		const auto tillSlideFinish = kSlideDuration - period;
 		if (!raw->animation.animating()) {
 			raw->animation.start(globalCallback, 0., 1., tillSlideFinish);
+			raw->animation.setPriority(Ui::Animations::Priority::Decorative);
 		}
 	}
 }
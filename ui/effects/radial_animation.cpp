@@ -7,6 +7,7 @@
 #include "ui/effects/radial_animation.h"
 
 #include "ui/arc_angles.h"
+#include "ui/cache_registry.h"
 #include "ui/painter.h"
 #include "styles/style_widgets.h"
 
@@ -15,6 +16,284 @@ namespace {
 
 constexpr auto kFullArcLength = arc::kFullLength;
 
+// Arc frames are cached starting at zero angle with the length rounded to
+// 1/128 of the circle, the start angle is applied by rotating the frame.
+constexpr auto kArcFrameStep = kFullArcLength / 128;
+constexpr auto kMaxArcFramesBytes = int64(4 * 1024 * 1024);
+
+// When a spinner's frames reach this size its other lengths are stroked.
+constexpr auto kMaxSpinnerArcFramesBytes = int64(512 * 1024);
+
+struct ArcSpinnerKey {
+	int width = 0;
+	int height = 0;
+	int thickness = 0; // In 1/64 of pixel.
+	QRgb color = 0;
+	int ratio = 0;
+
+	friend inline auto operator<=>(
+		const ArcSpinnerKey &,
+		const ArcSpinnerKey &) = default;
+	friend inline bool operator==(
+		const ArcSpinnerKey &,
+		const ArcSpinnerKey &) = default;
+};
+
+struct ArcFrameKey {
+	ArcSpinnerKey spinner;
+	int length = 0;
+
+	friend inline auto operator<=>(
+		const ArcFrameKey &,
+		const ArcFrameKey &) = default;
+	friend inline bool operator==(
+		const ArcFrameKey &,
+		const ArcFrameKey &) = default;
+};
+
+struct ArcFrame {
+	QImage image;
+	uint64 used = 0;
+};
+
+auto ArcFrames = std::map<ArcFrameKey, ArcFrame>();
+auto ArcFramesBytes = int64();
+auto ArcFramesCache = rpl::lifetime();
+auto ArcFramesCacheRegistered = false;
+
+[[nodiscard]] int64 ArcFrameSize(const ArcFrame &frame) {
+	return frame.image.sizeInBytes();
+}
+
+int64 EvictArcFrames(int64 bytes, uint64 tillUse) {
+	const auto result = EvictLeastUsed(
+		ArcFrames,
+		bytes,
+		tillUse,
+		ArcFrameSize);
+	ArcFramesBytes -= result;
+	return result;
+}
+
+void RegisterArcFramesCache() {
+	if (ArcFramesCacheRegistered) {
+		return;
+	}
+	ArcFramesCacheRegistered = true;
+	ArcFramesCache = RegisterCache({
+		.name = u"radial frames"_q,
+		.bytes = [] { return ArcFramesBytes; },
+		.oldestUse = [] { return OldestCacheUse(ArcFrames); },
+		.evict = EvictArcFrames,
+		.trim = [](CacheTrimLevel) {
+			ArcFrames.clear();
+			ArcFramesBytes = 0;
+		},
+	});
+}
+
+[[nodiscard]] int64 SpinnerArcFramesBytes(const ArcSpinnerKey &spinner) {
+	// Frames of one spinner are adjacent in the map, ordered by length.
+	auto result = int64();
+	const auto till = ArcFrames.upper_bound(ArcFrameKey{
+		.spinner = spinner,
+		.length = kFullArcLength,
+	});
+	for (auto i = ArcFrames.lower_bound(ArcFrameKey{ .spinner = spinner })
+		; i != till
+		; ++i) {
+		result += ArcFrameSize(i->second);
+	}
+	return result;
+}
+
+[[nodiscard]] int RoundToArcStep(int value) {
+	return ((value + (kArcFrameStep / 2)) / kArcFrameStep) * kArcFrameStep;
+}
+
+[[nodiscard]] int ArcFrameMargin(float64 thickness) {
+	return int(std::ceil(thickness / 2.)) + 1;
+}
+
+void PaintArcFrame(
+		QPainter &p,
+		const QRectF &rect,
+		const QImage &image,
+		float64 thickness,
+		int from) {
+	const auto margin = ArcFrameMargin(thickness);
+	p.save();
+	p.translate(rect.center());
+	p.rotate(-from / 16.);
+	p.setRenderHint(QPainter::SmoothPixmapTransform);
+	p.drawImage(
+		QPointF(
+			-rect.width() / 2. - margin,
+			-rect.height() / 2. - margin),
+		image);
+	p.restore();
+}
+
+void StrokeArc(
+		QPainter &p,
+		const QRectF &rect,
+		float64 thickness,
+		QPen pen,
+		int from,
+		int length) {
+	auto hq = PainterHighQualityEnabler(p);
+	pen.setWidthF(thickness);
+	pen.setCapStyle(Qt::RoundCap);
+	p.setPen(pen);
+	p.drawArc(rect, from, length);
+}
+
+[[nodiscard]] QImage PrepareArcFrame(
+		const ArcFrameKey &key,
+		float64 thickness,
+		const QPen &pen) {
+	const auto margin = ArcFrameMargin(thickness);
+	const auto &spinner = key.spinner;
+	const auto size = QSize(spinner.width, spinner.height)
+		+ QSize(margin, margin) * 2;
+	auto result = QImage(
+		size * spinner.ratio,
+		QImage::Format_ARGB32_Premultiplied);
+	result.setDevicePixelRatio(spinner.ratio);
+	result.fill(Qt::transparent);
+	{
+		auto q = QPainter(&result);
+		StrokeArc(
+			q,
+			QRectF(margin, margin, spinner.width, spinner.height),
+			thickness,
+			pen,
+			0,
+			key.length);
+	}
+	return result;
+}
+
+#ifdef _DEBUG
+[[nodiscard]] bool ArcFrameMatchesStroke(
+		const ArcFrameKey &key,
+		const QImage &frame,
+		float64 thickness,
+		const QPen &pen) {
+	// Paint the rotated frame and the stroked arc offscreen and compare.
+	// Resampling blurs the rotated edges a little, so allow small errors.
+	constexpr auto kFrom = kFullArcLength / 7;
+	const auto &spinner = key.spinner;
+	const auto margin = ArcFrameMargin(thickness);
+	const auto rect = QRectF(margin, margin, spinner.width, spinner.height);
+	const auto paint = [&](auto &&method) {
+		auto result = QImage(
+			frame.size(),
+			QImage::Format_ARGB32_Premultiplied);
+		result.setDevicePixelRatio(spinner.ratio);
+		result.fill(Qt::transparent);
+		{
+			auto q = QPainter(&result);
+			method(q);
+		}
+		return result;
+	};
+	const auto cached = paint([&](QPainter &q) {
+		PaintArcFrame(q, rect, frame, thickness, kFrom);
+	});
+	const auto stroked = paint([&](QPainter &q) {
+		StrokeArc(q, rect, thickness, pen, kFrom, key.length);
+	});
+	auto difference = int64();
+	for (auto y = 0; y != cached.height(); ++y) {
+		const auto a = reinterpret_cast<const QRgb*>(cached.constScanLine(y));
+		const auto b = reinterpret_cast<const QRgb*>(stroked.constScanLine(y));
+		for (auto x = 0; x != cached.width(); ++x) {
+			difference += std::abs(qAlpha(a[x]) - qAlpha(b[x]));
+		}
+	}
+	const auto pixels = int64(cached.width()) * cached.height();
+	return (difference <= pixels * 4);
+}
+#endif // _DEBUG
+
+// Draws the round-capped arc from a cached frame, if the painter allows it.
+bool DrawCachedArc(
+		QPainter &p,
+		const QRectF &rect,
+		float64 thickness,
+		const QPen &pen,
+		int from,
+		int length) {
+	const auto &transform = p.transform();
+	const auto position = rect.topLeft() + QPointF(
+		transform.dx(),
+		transform.dy());
+	const auto integral = [](float64 value) {
+		return (value == std::floor(value));
+	};
+	if (transform.type() > QTransform::TxTranslate
+		|| pen.style() != Qt::SolidLine
+		|| pen.brush().style() != Qt::SolidPattern
+		|| !integral(position.x())
+		|| !integral(position.y())
+		|| !integral(rect.width())
+		|| !integral(rect.height())
+		|| rect.width() != rect.height() // Elliptic arcs can't be rotated.
+		|| thickness <= 0.) {
+		return false;
+	}
+	const auto ratioF = float64(p.device()->devicePixelRatio());
+	const auto ratio = int(ratioF);
+	if (ratio < 1 || ratio != ratioF) {
+		return false;
+	}
+	if (length < 0) {
+		from += length;
+		length = -length;
+	}
+	const auto key = ArcFrameKey{
+		.spinner = {
+			.width = int(rect.width()),
+			.height = int(rect.height()),
+			.thickness = int(base::SafeRound(thickness * 64)),
+			.color = pen.color().rgba(),
+			.ratio = ratio,
+		},
+		.length = std::clamp(RoundToArcStep(length), 0, kFullArcLength),
+	};
+	if (!key.length) {
+		// Short arcs are drawn as dots directly, not skipped.
+		return false;
+	}
+	auto i = ArcFrames.find(key);
+	if (i == end(ArcFrames)) {
+		const auto side = (key.spinner.width + 2 * ArcFrameMargin(thickness))
+			* ratio;
+		const auto bytes = int64(side) * side * 4;
+		if (SpinnerArcFramesBytes(key.spinner) + bytes
+			> kMaxSpinnerArcFramesBytes) {
+			return false;
+		}
+		auto image = PrepareArcFrame(key, thickness, pen);
+		RegisterArcFramesCache();
+		if (ArcFramesBytes + bytes > kMaxArcFramesBytes) {
+			EvictArcFrames(
+				ArcFramesBytes + bytes - kMaxArcFramesBytes,
+				uint64(-1));
+		}
+#ifdef _DEBUG
+		Assert(ArcFrameMatchesStroke(key, image, thickness, pen));
+#endif // _DEBUG
+		i = ArcFrames.emplace(key, ArcFrame{ std::move(image) }).first;
+		ArcFramesBytes += ArcFrameSize(i->second);
+		CacheGrown();
+	}
+	i->second.used = NextCacheUseTick();
+	PaintArcFrame(p, rect, i->second.image, thickness, from);
+	return true;
+}
+
 } // namespace
 
 const int RadialState::kFull = kFullArcLength;
@@ -217,7 +496,13 @@ void InfiniteRadialAnimation::Draw(
 	const auto brush = p.brush();
 	if (anim::Disabled()) {
 		anim::DrawStaticLoading(p, rect, thickness, pen);
-	} else {
+	} else if (!DrawCachedArc(
+			p,
+			rect,
+			thickness,
+			pen,
+			state.arcFrom,
+			state.arcLength)) {
 		pen.setWidth(thickness);
 		pen.setCapStyle(Qt::RoundCap);
 		p.setPen(pen);
@@ -62,6 +62,7 @@ template <typename Callback>
 inline RadialAnimation::RadialAnimation(Callback &&callback)
 : _arcStart(0, RadialState::kFull)
 , _animation(std::forward<Callback>(callback)) {
+	_animation.setPriority(Animations::Priority::Decorative);
 }
 
 
@@ -123,6 +124,7 @@ inline InfiniteRadialAnimation::InfiniteRadialAnimation(
 	const style::InfiniteRadialAnimation &st)
 : _st(st)
 , _animation(std::forward<Callback>(callback)) {
+	_animation.setPriority(Animations::Priority::Decorative);
 	init();
 }
 
@@ -13,6 +13,11 @@
 #include "styles/style_widgets.h"
 
 namespace Ui {
+namespace {
+
+auto RippleMasksBytes = std::atomic<int64>();
+
+} // namespace
 
 class RippleAnimation::Ripple {
 public:
@@ -182,7 +187,10 @@ RippleAnimation::RippleAnimation(
 	Fn<void()> callback)
 : _st(st)
 , _mask(PixmapFromImage(std::move(mask)))
+, _maskBytes(&RippleMasksBytes)
 , _update(std::move(callback)) {
+	RegisterReportedCache(u"ripple masks"_q, &RippleMasksBytes);
+	_maskBytes.set(int64(_mask.width()) * _mask.height() * 4);
 }
 
 
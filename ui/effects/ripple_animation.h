@@ -6,6 +6,8 @@
 //
 #pragma once
 
+#include "ui/cache_registry.h"
+
 #include <deque>
 
 namespace Images {
@@ -62,6 +64,7 @@ private:
 
 	const style::RippleAnimation &_st;
 	QPixmap _mask;
+	ReportedCacheBytes _maskBytes;
 	Fn<void()> _update;
 
 	class Ripple;
@@ -312,6 +312,7 @@ SpoilerAnimationManager::SpoilerAnimationManager(
 	Expects(!DefaultAnimationManager);
 
 	DefaultAnimationManager = this;
+	_animation.setPriority(Ui::Animations::Priority::Decorative);
 	_animation.start();
 }
 
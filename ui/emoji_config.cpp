@@ -13,6 +13,7 @@
 #include "base/parse_helper.h"
 #include "base/debug_log.h"
 #include "ui/style/style_core.h"
+#include "ui/cache_registry.h"
 #include "ui/integration.h"
 #include "ui/painter.h"
 #include "ui/ui_utility.h"
@@ -25,6 +26,8 @@
 
 #include <crl/crl_async.h>
 
+#include <atomic>
+
 namespace Ui {
 namespace Emoji {
 namespace {
@@ -37,10 +40,56 @@ constexpr auto kSetVersion = uint32(7);
 constexpr auto kCacheVersion = uint32(9);
 constexpr auto kMaxId = uint32(1 << 8);
 
+// Fallback emoji are drawn only while the cache is being generated.
+constexpr auto kMaxUniversalSingles = 256;
+
 #ifdef Q_OS_MAC
 constexpr auto kScaleForTouchBar = 150;
 #endif
 
+constexpr auto kKeycap = char16_t(0x20E3);
+constexpr auto kNonAsciiMask = uint64(0xFF80FF80FF80FF80ULL);
+
+// A bit for each code unit that can start an emoji sequence.
+auto StartUnits = std::array<uint64, 0x10000 / 64>();
+auto StartUnitsReady = std::atomic<bool>();
+
+void FillStartUnits() {
+	const auto add = [](char16_t unit) {
+		StartUnits[unit >> 6] |= (uint64(1) << (unit & 63));
+	};
+	for (auto i = 0, count = internal::FullCount(); i != count; ++i) {
+		const auto id = internal::ByIndex(i)->id();
+		if (!id.isEmpty()) {
+			add(id[0].unicode());
+		}
+	}
+
+	// The generated matcher accepts some sequences in alternative forms,
+	// so all the high surrogates and the symbol blocks are kept as well.
+	for (auto unit = 0xD800; unit != 0xDC00; ++unit) {
+		add(char16_t(unit));
+	}
+	for (auto unit = 0x2000; unit != 0x3300; ++unit) {
+		add(char16_t(unit));
+	}
+	add(char16_t(0x00A9));
+	add(char16_t(0x00AE));
+	StartUnitsReady.store(true, std::memory_order_release);
+}
+
+[[nodiscard]] bool CanStartEmoji(const QChar *ch, const QChar *end) {
+	const auto unit = ch->unicode();
+	if (!(StartUnits[unit >> 6] & (uint64(1) << (unit & 63)))) {
+		return false;
+	} else if (unit >= 0x80) {
+		return true;
+	}
+	// Keycaps: a digit, '#' or '*' followed by the postfix or keycap.
+	const auto next = (ch + 1 != end) ? (ch + 1)->unicode() : 0;
+	return (next == kPostfix) || (next == kKeycap);
+}
+
 enum class ConfigResult {
 	Invalid,
 	BadVersion,
@@ -61,6 +110,7 @@ private:
 	void readCache();
 	void generateCache();
 	void checkUniversalImages();
+	void universalImagesFailed();
 	void pushSprite(QImage &&data);
 
 	int _id = 0;
@@ -88,8 +138,48 @@ auto TouchbarInstance = std::unique_ptr<Instance>();
 auto TouchbarEmoji = (Instance*)nullptr;
 #endif
 
-auto MainEmojiMap = std::map<int, QPixmap>();
-auto OtherEmojiMap = base::flat_map<int, std::map<int, QPixmap>>();
+struct SingleEmoji {
+	QPixmap pixmap;
+	uint64 used = 0;
+};
+auto SingleEmojiMap = std::map<uint64, SingleEmoji>();
+auto SingleEmojiBytes = int64();
+auto SingleEmojiCache = rpl::lifetime();
+
+[[nodiscard]] int64 SingleEmojiSize(const SingleEmoji &entry) {
+	return int64(entry.pixmap.width()) * entry.pixmap.height() * 4;
+}
+
+void ClearSingleEmoji() {
+	SingleEmojiMap.clear();
+	SingleEmojiBytes = 0;
+}
+
+int64 EvictSingleEmoji(int64 bytes, uint64 tillUse) {
+	const auto result = EvictLeastUsed(
+		SingleEmojiMap,
+		bytes,
+		tillUse,
+		SingleEmojiSize);
+	SingleEmojiBytes -= result;
+	return result;
+}
+
+void RegisterSingleEmojiCache() {
+	SingleEmojiCache = RegisterCache({
+		.name = u"emoji"_q,
+		.bytes = [] { return SingleEmojiBytes; },
+		.oldestUse = [] { return OldestCacheUse(SingleEmojiMap); },
+		.evict = EvictSingleEmoji,
+		.trim = [](CacheTrimLevel level) {
+			if (level == CacheTrimLevel::Critical) {
+				ClearSingleEmoji();
+			} else {
+				EvictSingleEmoji(SingleEmojiBytes / 2, uint64(-1));
+			}
+		},
+	});
+}
 
 int RowsCount(int index) {
 	if (index + 1 < SpritesCount) {
@@ -149,8 +239,7 @@ int ReadCurrentSetId() {
 void ApplyUniversalImages(std::shared_ptr<UniversalImages> images) {
 	Universal = std::move(images);
 	CanClearUniversal = false;
-	MainEmojiMap.clear();
-	OtherEmojiMap.clear();
+	ClearSingleEmoji();
 	Updates.fire({});
 }
 
@@ -205,7 +294,6 @@ void ClearCurrentSetIdSync() {
 
 	const auto newId = 0;
 	auto universal = std::make_shared<UniversalImages>(newId);
-	universal->ensureLoaded();
 
 	// Start loading the set when possible.
 	ApplyUniversalImages(std::move(universal));
@@ -315,51 +403,23 @@ QImage LoadFromFile(int id, int size, int index) {
 	return result;
 }
 
-std::vector<QImage> LoadSprites(int id) {
+QImage LoadSprite(int id, int index) {
 	Expects(IsValidSetId(id));
-	Expects(SpritesCount > 0);
+	Expects(index >= 0 && index < SpritesCount);
 
-	auto result = std::vector<QImage>();
 	const auto folder = (id != 0)
 		? internal::SetDataPath(id) + '/'
 		: QStringLiteral(":/gui/emoji/");
-	const auto base = folder + "emoji_";
-	return ranges::views::ints(
-		0,
-		SpritesCount
-	) | ranges::views::transform([&](int index) {
-		return base + QString::number(index + 1) + ".webp";
-	}) | ranges::views::transform([](const QString &path) {
-		return QImage(path, "WEBP").convertToFormat(
-			QImage::Format_ARGB32_Premultiplied);
-	}) | ranges::to_vector;
-}
-
-std::vector<QImage> LoadAndValidateSprites(int id) {
-	Expects(IsValidSetId(id));
-	Expects(SpritesCount > 0);
-
-	const auto config = ValidateConfig(id);
-	if (config != ConfigResult::Good) {
-		return {};
-	}
-	auto result = LoadSprites(id);
-	const auto sizes = ranges::views::ints(
-		0,
-		SpritesCount
-	) | ranges::views::transform([](int index) {
-		return QSize(
-			kImagesPerRow * kUniversalSize,
-			RowsCount(index) * kUniversalSize);
-	});
-	const auto good = ranges::views::zip_with(
-		[](const QImage &data, QSize size) { return data.size() == size; },
-		result,
-		sizes);
-	if (ranges::find(good, false) != end(good)) {
-		return {};
-	}
-	return result;
+	const auto path = folder
+		+ "emoji_"
+		+ QString::number(index + 1)
+		+ ".webp";
+	auto result = QImage(path, "WEBP").convertToFormat(
+		QImage::Format_ARGB32_Premultiplied);
+	const auto size = QSize(
+		kImagesPerRow * kUniversalSize,
+		RowsCount(index) * kUniversalSize);
+	return (result.size() == size) ? result : QImage();
 }
 
 void ClearUniversalChecked() {
@@ -402,15 +462,101 @@ int UniversalImages::id() const {
 bool UniversalImages::ensureLoaded() {
 	Expects(SpritesCount > 0);
 
-	if (!_sprites.empty()) {
-		return true;
+	for (auto i = 0; i != SpritesCount; ++i) {
+		if (sprite(i).isNull()) {
+			return false;
+		}
 	}
-	_sprites = LoadAndValidateSprites(_id);
-	return !_sprites.empty();
+	return true;
 }
 
 void UniversalImages::clear() {
+	QMutexLocker lock(&_mutex);
 	_sprites.clear();
+	_state = State::Unknown;
+	++_generation;
+	lock.unlock();
+
+	_singles.clear();
+	_spritesRequested.clear();
+}
+
+QImage UniversalImages::sprite(int index) const {
+	Expects(SpritesCount > 0);
+	Expects(index >= 0 && index < SpritesCount);
+
+	QMutexLocker lock(&_mutex);
+	while (true) {
+		if (_state == State::Unknown) {
+			if (ValidateConfig(_id) != ConfigResult::Good) {
+				_state = State::Invalid;
+			} else {
+				_state = State::Valid;
+				_sprites.resize(SpritesCount);
+			}
+		}
+		if (_state == State::Invalid) {
+			return QImage();
+		}
+		const auto &sprite = _sprites[index];
+		if (!sprite.image.isNull()) {
+			return sprite.image;
+		} else if (!sprite.decoding) {
+			break;
+		}
+		// Concurrent cache generations for different sizes
+		// wait for the sprite instead of decoding it twice.
+		_decoded.wait(&_mutex);
+	}
+	_sprites[index].decoding = true;
+	const auto generation = _generation;
+	lock.unlock();
+
+	auto result = LoadSprite(_id, index);
+
+	lock.relock();
+	if (_generation == generation) {
+		if (result.isNull()) {
+			_state = State::Invalid;
+			_sprites.clear();
+		} else {
+			_sprites[index] = Sprite{ .image = result };
+		}
+	}
+	_decoded.wakeAll();
+	return result;
+}
+
+QImage UniversalImages::decodedSprite(int index) const {
+	Expects(index >= 0 && index < SpritesCount);
+
+	// The mutex is never held while decoding, so this doesn't block.
+	QMutexLocker lock(&_mutex);
+	return (_state == State::Valid)
+		? _sprites[index].image
+		: QImage();
+}
+
+void UniversalImages::requestSprite(int index) const {
+	if (!_spritesRequested.emplace(index).second) {
+		return;
+	}
+	crl::async([weak = weak_from_this(), index] {
+		const auto strong = weak.lock();
+		if (!strong) {
+			return;
+		}
+		const auto loaded = !strong->sprite(index).isNull();
+		crl::on_main([=] {
+			const auto strong = weak.lock();
+			if (!strong || !loaded) {
+				// Failed sprites are not requested again.
+				return;
+			}
+			strong->_spritesRequested.remove(index);
+			Updates.fire({});
+		});
+	});
 }
 
 void UniversalImages::draw(
@@ -419,37 +565,60 @@ void UniversalImages::draw(
 		int size,
 		int x,
 		int y) const {
-	Expects(emoji->sprite() < _sprites.size());
-
-	const auto large = kUniversalSize;
-	const auto &original = _sprites[emoji->sprite()];
-	const auto data = original.bits();
-	const auto stride = original.bytesPerLine();
-	const auto format = original.format();
-	const auto row = emoji->row();
-	const auto column = emoji->column();
-	auto single = QImage(
-		data + (row * kImagesPerRow * large + column) * large * 4,
-		large,
-		large,
-		stride,
-		format
-	).scaled(
-		size,
-		size,
-		Qt::IgnoreAspectRatio,
-		Qt::SmoothTransformation);
-	single.setDevicePixelRatio(p.device()->devicePixelRatio());
-	p.drawImage(x, y, single);
+	const auto key = (uint64(uint32(size)) << 32)
+		| uint64(uint32(emoji->index()));
+	auto i = _singles.find(key);
+	if (i == end(_singles)) {
+		// Decoding a sprite takes a while, so it is done in background
+		// and the emoji is skipped until the sprite is ready.
+		const auto original = decodedSprite(emoji->sprite());
+		if (original.isNull()) {
+			requestSprite(emoji->sprite());
+			return;
+		}
+		const auto large = kUniversalSize;
+		const auto data = original.bits();
+		const auto stride = original.bytesPerLine();
+		const auto format = original.format();
+		const auto row = emoji->row();
+		const auto column = emoji->column();
+		auto single = QImage(
+			data + (row * kImagesPerRow * large + column) * large * 4,
+			large,
+			large,
+			stride,
+			format
+		).scaled(
+			size,
+			size,
+			Qt::IgnoreAspectRatio,
+			Qt::SmoothTransformation);
+		if (_singles.size() >= kMaxUniversalSingles) {
+			_singles.erase(ranges::min_element(
+				_singles,
+				ranges::less(),
+				[](const auto &pair) { return pair.second.used; }));
+		}
+		i = _singles.emplace(key, Single{ std::move(single) }).first;
+	}
+	i->second.used = NextCacheUseTick();
+	auto &image = i->second.image;
+	const auto ratio = p.device()->devicePixelRatio();
+	if (image.devicePixelRatio() != ratio) {
+		image.setDevicePixelRatio(ratio);
+	}
+	p.drawImage(x, y, image);
 }
 
 QImage UniversalImages::generate(int size, int index) const {
 	Expects(size > 0);
-	Expects(index < _sprites.size());
 
+	const auto original = sprite(index);
+	if (original.isNull()) {
+		return QImage();
+	}
 	const auto rows = RowsCount(index);
 	const auto large = kUniversalSize;
-	const auto &original = _sprites[index];
 	const auto data = original.bits();
 	const auto stride = original.bytesPerLine();
 	const auto format = original.format();
@@ -486,6 +655,7 @@ QImage UniversalImages::generate(int size, int index) const {
 
 void Init() {
 	internal::Init();
+	FillStartUnits();
 
 	// Pre-warm InstantReplaces trie on background thread.
 	crl::async([] { InstantReplaces::Default(); });
@@ -499,6 +669,8 @@ void Init() {
 	Universal = std::make_shared<UniversalImages>(ReadCurrentSetId());
 	CanClearUniversal = false;
 
+	RegisterSingleEmojiCache();
+
 	InstanceNormal = std::make_unique<Instance>(SizeNormal);
 	InstanceLarge = std::make_unique<Instance>(SizeLarge);
 
@@ -514,9 +686,45 @@ void Init() {
 #endif
 }
 
+EmojiPtr Find(const QChar *start, const QChar *end, int *outLength) {
+	if (start != end
+		&& StartUnitsReady.load(std::memory_order_acquire)
+		&& !CanStartEmoji(start, end)) {
+		return nullptr;
+	}
+	return internal::Find(start, end, outLength);
+}
+
+const QChar *SkipToPossibleEmoji(const QChar *start, const QChar *end) {
+	if (!StartUnitsReady.load(std::memory_order_acquire)) {
+		return start;
+	}
+	auto ch = start;
+	while (ch != end) {
+		// Skip ASCII four code units at a time. A keycap base can start
+		// an emoji only if followed by a non-ASCII unit, so the unit after
+		// the block is checked as well.
+		while (end - ch > 4) {
+			auto word = uint64();
+			memcpy(&word, ch, sizeof(word));
+			if ((word & kNonAsciiMask) || (ch + 4)->unicode() >= 0x80) {
+				break;
+			}
+			ch += 4;
+		}
+		const auto till = (end - ch > 4) ? (ch + 4) : end;
+		for (; ch != till; ++ch) {
+			if (CanStartEmoji(ch, end)) {
+				return ch;
+			}
+		}
+	}
+	return end;
+}
+
 void Clear() {
-	MainEmojiMap.clear();
-	OtherEmojiMap.clear();
+	ClearSingleEmoji();
+	SingleEmojiCache.destroy();
 
 	InstanceNormal = nullptr;
 	InstanceLarge = nullptr;
@@ -753,12 +961,12 @@ QVector<EmojiPtr> GetDefaultRecent() {
 
 const QPixmap &SinglePixmap(EmojiPtr emoji, int fontHeight) {
 	const auto factor = style::DevicePixelRatio();
-	auto &map = (fontHeight == st::normalFont->height * factor)
-		? MainEmojiMap
-		: OtherEmojiMap[fontHeight];
-	auto i = map.find(emoji->index());
-	if (i != end(map)) {
-		return i->second;
+	const auto key = (uint64(uint32(fontHeight)) << 32)
+		| uint64(uint32(emoji->index()));
+	auto i = SingleEmojiMap.find(key);
+	if (i != end(SingleEmojiMap)) {
+		i->second.used = NextCacheUseTick();
+		return i->second.pixmap;
 	}
 	auto image = QImage(
 		SizeNormal + st::emojiPadding * factor * 2,
@@ -776,10 +984,13 @@ const QPixmap &SinglePixmap(EmojiPtr emoji, int fontHeight) {
 			st::emojiPadding,
 			(fontHeight - SizeNormal) / (2 * factor));
 	}
-	return map.emplace(
-		emoji->index(),
-		PixmapFromImage(std::move(image))
-	).first->second;
+	auto entry = SingleEmoji{
+		.pixmap = PixmapFromImage(std::move(image)),
+		.used = NextCacheUseTick(),
+	};
+	SingleEmojiBytes += SingleEmojiSize(entry);
+	CacheGrown();
+	return SingleEmojiMap.emplace(key, std::move(entry)).first->second.pixmap;
 }
 
 void Draw(QPainter &p, EmojiPtr emoji, int size, int x, int y) {
@@ -852,12 +1063,16 @@ void Instance::checkUniversalImages() {
 		_generating = nullptr;
 		_sprites.clear();
 	}
-	if (!Universal->ensureLoaded()) {
-		if (Universal->id() != 0) {
-			ClearCurrentSetIdSync();
-		} else {
-			_unsupported = true;
-		}
+}
+
+void Instance::universalImagesFailed() {
+	Expects(Universal != nullptr);
+
+	if (Universal->id() != 0) {
+		ClearCurrentSetIdSync();
+		generateCache();
+	} else {
+		_unsupported = true;
 	}
 }
 
@@ -882,6 +1097,9 @@ void Instance::generateCache() {
 		]() mutable {
 			if (universal != Universal) {
 				return;
+			} else if (image.isNull()) {
+				universalImagesFailed();
+				return;
 			}
 			pushSprite(std::move(image));
 			if (cached()) {
@@ -8,9 +8,13 @@
 
 #include "base/basic_types.h"
 #include "base/binary_guard.h"
+#include "base/flat_map.h"
+#include "base/flat_set.h"
 #include "base/qt/qt_string_view.h"
 #include "emoji.h"
 
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
 #include <QtGui/QPainter>
 #include <QtGui/QPixmap>
 
@@ -123,9 +127,16 @@ private:
 	return nullptr;
 }
 
-[[nodiscard]] inline EmojiPtr Find(const QChar *start, const QChar *end, int *outLength = nullptr) {
-	return internal::Find(start, end, outLength);
-}
+// Rejects positions that can't start an emoji before the full lookup.
+[[nodiscard]] EmojiPtr Find(
+	const QChar *start,
+	const QChar *end,
+	int *outLength = nullptr);
+
+// Returns the first position in [start, end) where an emoji may start.
+[[nodiscard]] const QChar *SkipToPossibleEmoji(
+	const QChar *start,
+	const QChar *end);
 
 [[nodiscard]] inline EmojiPtr Find(QStringView text, int *outLength = nullptr) {
 	return Find(text.begin(), text.end(), outLength);
@@ -157,7 +168,8 @@ QVector<EmojiPtr> GetDefaultRecent();
 const QPixmap &SinglePixmap(EmojiPtr emoji, int fontHeight);
 void Draw(QPainter &p, EmojiPtr emoji, int size, int x, int y);
 
-class UniversalImages {
+class UniversalImages final
+	: public std::enable_shared_from_this<UniversalImages> {
 public:
 	explicit UniversalImages(int id);
 
@@ -167,13 +179,43 @@ public:
 
 	void draw(QPainter &p, EmojiPtr emoji, int size, int x, int y) const;
 
-	// This method must be thread safe and so it is called after
-	// the _id value is fixed and all _sprites are loaded.
+	// This method must be thread safe, sprites are decoded on demand.
+	// Returns a null image if the sprite could not be loaded.
 	QImage generate(int size, int index) const;
 
 private:
+	enum class State : uchar {
+		Unknown,
+		Valid,
+		Invalid,
+	};
+	struct Sprite {
+		QImage image;
+		bool decoding = false;
+	};
+	struct Single {
+		QImage image;
+		uint64 used = 0;
+	};
+
+	[[nodiscard]] QImage sprite(int index) const;
+
+	// Main thread only, never waits for a sprite to be decoded.
+	[[nodiscard]] QImage decodedSprite(int index) const;
+	void requestSprite(int index) const;
+
 	const int _id = 0;
-	std::vector<QImage> _sprites;
+
+	// Sprites are decoded outside of the mutex, it guards only the state.
+	mutable QMutex _mutex;
+	mutable QWaitCondition _decoded;
+	mutable std::vector<Sprite> _sprites;
+	mutable State _state = State::Unknown;
+	mutable int _generation = 0;
+
+	// Downscaled fallback images, used only from the main thread.
+	mutable base::flat_map<uint64, Single> _singles;
+	mutable base::flat_set<int> _spritesRequested;
 
 };
 
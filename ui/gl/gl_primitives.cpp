@@ -8,10 +8,46 @@
 
 #include "ui/gl/gl_shader.h"
 #include "ui/style/style_core.h"
+#include "base/flat_map.h"
 
 #include <QtGui/QOpenGLFunctions>
 
 namespace Ui::GL {
+namespace {
+
+struct ProgramLocations {
+	GLuint programId = 0;
+	GLint position = -1;
+	GLint texcoord = -1;
+	GLint color = -1;
+};
+
+auto Locations = base::flat_map<
+	not_null<QOpenGLShaderProgram*>,
+	ProgramLocations>();
+
+[[nodiscard]] const ProgramLocations &LookupLocations(
+		not_null<QOpenGLShaderProgram*> program) {
+	const auto programId = program->programId();
+	auto i = Locations.find(program);
+	if (i == end(Locations)) {
+		QObject::connect(program, &QObject::destroyed, [=] {
+			Locations.remove(program);
+		});
+		i = Locations.emplace(program, ProgramLocations()).first;
+	} else if (i->second.programId == programId) {
+		return i->second;
+	}
+	i->second = ProgramLocations{
+		.programId = programId,
+		.position = program->attributeLocation("position"),
+		.texcoord = program->attributeLocation("v_texcoordIn"),
+		.color = program->uniformLocation("s_color"),
+	};
+	return i->second;
+}
+
+} // namespace
 
 static_assert(std::is_same_v<float, GLfloat>);
 
@@ -38,12 +74,18 @@ void FillTriangles(
 	if (coords.empty()) {
 		return;
 	}
+	const auto bytes = int(coords.size() * sizeof(GLfloat));
 	buffer->bind();
-	buffer->allocate(coords.data(), coords.size() * sizeof(GLfloat));
+	if (buffer->size() < bytes) {
+		buffer->allocate(coords.data(), bytes);
+	} else {
+		buffer->write(0, coords.data(), bytes);
+	}
 
-	program->setUniformValue("s_color", color);
+	const auto &locations = LookupLocations(program);
+	program->setUniformValue(locations.color, color);
 
-	GLint position = program->attributeLocation("position");
+	const auto position = locations.position;
 	f.glVertexAttribPointer(
 		position,
 		2,
@@ -71,9 +113,10 @@ void FillRectangle(
 		return reinterpret_cast<const void*>(
 			(skipVertices * 4 + elements) * sizeof(GLfloat));
 	};
-	program->setUniformValue("s_color", color);
+	const auto &locations = LookupLocations(program);
+	program->setUniformValue(locations.color, color);
 
-	GLint position = program->attributeLocation("position");
+	const auto position = locations.position;
 	f.glVertexAttribPointer(
 		position,
 		2,
@@ -96,7 +139,8 @@ void FillTexturedRectangle(
 		return reinterpret_cast<const void*>(
 			(skipVertices * 4 + elements) * sizeof(GLfloat));
 	};
-	GLint position = program->attributeLocation("position");
+	const auto &locations = LookupLocations(program);
+	const auto position = locations.position;
 	f.glVertexAttribPointer(
 		position,
 		2,
@@ -106,7 +150,7 @@ void FillTexturedRectangle(
 		shift(0));
 	f.glEnableVertexAttribArray(position);
 
-	GLint texcoord = program->attributeLocation("v_texcoordIn");
+	const auto texcoord = locations.texcoord;
 	f.glVertexAttribPointer(
 		texcoord,
 		2,
@@ -122,4 +166,58 @@ void FillTexturedRectangle(
 	f.glDisableVertexAttribArray(texcoord);
 }
 
+TrianglesBatch::TrianglesBatch(not_null<QOpenGLBuffer*> buffer)
+: _buffer(buffer) {
+}
+
+void TrianglesBatch::addRect(
+		QOpenGLFunctions &f,
+		not_null<QOpenGLShaderProgram*> program,
+		Rect rect,
+		const QColor &color) {
+	if (rect.empty()) {
+		return;
+	}
+	prepare(f, program, color);
+	const auto was = _coords.size();
+	_coords.resize(was + 12);
+	FillRectTriangleVertices(_coords.data() + was, rect);
+}
+
+void TrianglesBatch::addTriangles(
+		QOpenGLFunctions &f,
+		not_null<QOpenGLShaderProgram*> program,
+		gsl::span<const float> coords,
+		const QColor &color) {
+	Expects(coords.size() % 6 == 0);
+
+	if (coords.empty()) {
+		return;
+	}
+	prepare(f, program, color);
+	_coords.insert(end(_coords), coords.begin(), coords.end());
+}
+
+void TrianglesBatch::prepare(
+		QOpenGLFunctions &f,
+		not_null<QOpenGLShaderProgram*> program,
+		const QColor &color) {
+	if (_program != program || _color != color) {
+		flush(f);
+		_program = program;
+		_color = color;
+	}
+}
+
+void TrianglesBatch::flush(QOpenGLFunctions &f) {
+	if (_coords.empty()) {
+		return;
+	}
+	Assert(_program != nullptr);
+
+	_program->bind();
+	FillTriangles(f, _coords, _buffer, _program, _color);
+	_coords.clear();
+}
+
 } // namespace Ui::GL
@@ -36,4 +36,37 @@ void FillTexturedRectangle(
 	not_null<QOpenGLShaderProgram*> program,
 	int skipVertices = 0);
 
+// Collects solid triangles for a frame and draws each run of primitives
+// sharing the same program and color with a single glDrawArrays call.
+// The vertex buffer is only reallocated when it needs to grow.
+class TrianglesBatch final {
+public:
+	explicit TrianglesBatch(not_null<QOpenGLBuffer*> buffer);
+
+	void addRect(
+		QOpenGLFunctions &f,
+		not_null<QOpenGLShaderProgram*> program,
+		Rect rect,
+		const QColor &color);
+	void addTriangles(
+		QOpenGLFunctions &f,
+		not_null<QOpenGLShaderProgram*> program,
+		gsl::span<const float> coords,
+		const QColor &color);
+
+	void flush(QOpenGLFunctions &f);
+
+private:
+	void prepare(
+		QOpenGLFunctions &f,
+		not_null<QOpenGLShaderProgram*> program,
+		const QColor &color);
+
+	const not_null<QOpenGLBuffer*> _buffer;
+	QOpenGLShaderProgram *_program = nullptr;
+	QColor _color;
+	std::vector<float> _coords;
+
+};
+
 } // namespace Ui::GL
@@ -303,6 +303,238 @@ template <int kBits> // 4 means 16x16, 3 means 8x8
 			Qt::SmoothTransformation);
 }
 
+constexpr char kInlineJpegHeader[] = "\xff\xd8\xff\xe0\x00\x10\x4a\x46\x49"
+	"\x46\x00\x01\x01\x00\x00\x01\x00\x01\x00\x00\xff\xdb\x00\x43\x00\x28\x1c"
+	"\x1e\x23\x1e\x19\x28\x23\x21\x23\x2d\x2b\x28\x30\x3c\x64\x41\x3c\x37\x37"
+	"\x3c\x7b\x58\x5d\x49\x64\x91\x80\x99\x96\x8f\x80\x8c\x8a\xa0\xb4\xe6\xc3"
+	"\xa0\xaa\xda\xad\x8a\x8c\xc8\xff\xcb\xda\xee\xf5\xff\xff\xff\x9b\xc1\xff"
+	"\xff\xff\xfa\xff\xe6\xfd\xff\xf8\xff\xdb\x00\x43\x01\x2b\x2d\x2d\x3c\x35"
+	"\x3c\x76\x41\x41\x76\xf8\xa5\x8c\xa5\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8"
+	"\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8"
+	"\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8"
+	"\xf8\xf8\xf8\xf8\xf8\xff\xc0\x00\x11\x08\x00\x00\x00\x00\x03\x01\x22\x00"
+	"\x02\x11\x01\x03\x11\x01\xff\xc4\x00\x1f\x00\x00\x01\x05\x01\x01\x01\x01"
+	"\x01\x01\x00\x00\x00\x00\x00\x00\x00\x00\x01\x02\x03\x04\x05\x06\x07\x08"
+	"\x09\x0a\x0b\xff\xc4\x00\xb5\x10\x00\x02\x01\x03\x03\x02\x04\x03\x05\x05"
+	"\x04\x04\x00\x00\x01\x7d\x01\x02\x03\x00\x04\x11\x05\x12\x21\x31\x41\x06"
+	"\x13\x51\x61\x07\x22\x71\x14\x32\x81\x91\xa1\x08\x23\x42\xb1\xc1\x15\x52"
+	"\xd1\xf0\x24\x33\x62\x72\x82\x09\x0a\x16\x17\x18\x19\x1a\x25\x26\x27\x28"
+	"\x29\x2a\x34\x35\x36\x37\x38\x39\x3a\x43\x44\x45\x46\x47\x48\x49\x4a\x53"
+	"\x54\x55\x56\x57\x58\x59\x5a\x63\x64\x65\x66\x67\x68\x69\x6a\x73\x74\x75"
+	"\x76\x77\x78\x79\x7a\x83\x84\x85\x86\x87\x88\x89\x8a\x92\x93\x94\x95\x96"
+	"\x97\x98\x99\x9a\xa2\xa3\xa4\xa5\xa6\xa7\xa8\xa9\xaa\xb2\xb3\xb4\xb5\xb6"
+	"\xb7\xb8\xb9\xba\xc2\xc3\xc4\xc5\xc6\xc7\xc8\xc9\xca\xd2\xd3\xd4\xd5\xd6"
+	"\xd7\xd8\xd9\xda\xe1\xe2\xe3\xe4\xe5\xe6\xe7\xe8\xe9\xea\xf1\xf2\xf3\xf4"
+	"\xf5\xf6\xf7\xf8\xf9\xfa\xff\xc4\x00\x1f\x01\x00\x03\x01\x01\x01\x01\x01"
+	"\x01\x01\x01\x01\x00\x00\x00\x00\x00\x00\x01\x02\x03\x04\x05\x06\x07\x08"
+	"\x09\x0a\x0b\xff\xc4\x00\xb5\x11\x00\x02\x01\x02\x04\x04\x03\x04\x07\x05"
+	"\x04\x04\x00\x01\x02\x77\x00\x01\x02\x03\x11\x04\x05\x21\x31\x06\x12\x41"
+	"\x51\x07\x61\x71\x13\x22\x32\x81\x08\x14\x42\x91\xa1\xb1\xc1\x09\x23\x33"
+	"\x52\xf0\x15\x62\x72\xd1\x0a\x16\x24\x34\xe1\x25\xf1\x17\x18\x19\x1a\x26"
+	"\x27\x28\x29\x2a\x35\x36\x37\x38\x39\x3a\x43\x44\x45\x46\x47\x48\x49\x4a"
+	"\x53\x54\x55\x56\x57\x58\x59\x5a\x63\x64\x65\x66\x67\x68\x69\x6a\x73\x74"
+	"\x75\x76\x77\x78\x79\x7a\x82\x83\x84\x85\x86\x87\x88\x89\x8a\x92\x93\x94"
+	"\x95\x96\x97\x98\x99\x9a\xa2\xa3\xa4\xa5\xa6\xa7\xa8\xa9\xaa\xb2\xb3\xb4"
+	"\xb5\xb6\xb7\xb8\xb9\xba\xc2\xc3\xc4\xc5\xc6\xc7\xc8\xc9\xca\xd2\xd3\xd4"
+	"\xd5\xd6\xd7\xd8\xd9\xda\xe2\xe3\xe4\xe5\xe6\xe7\xe8\xe9\xea\xf2\xf3\xf4"
+	"\xf5\xf6\xf7\xf8\xf9\xfa\xff\xda\x00\x0c\x03\x01\x00\x02\x11\x03\x11\x00"
+	"\x3f\x00";
+
+constexpr char kInlineJpegFooter[] = "\xff\xd9";
+constexpr auto kInlineJpegHeightIndex = 164;
+constexpr auto kInlineJpegWidthIndex = 166;
+
+// Feeds libjpeg with the inline JPEG header, payload and footer without
+// concatenating them into a single buffer.
+struct InlineJpegSource {
+	jpeg_source_mgr manager = {};
+	std::array<JOCTET, sizeof(kInlineJpegHeader) - 1> header = {};
+	std::array<std::pair<const JOCTET*, size_t>, 3> parts = {};
+	int part = 0;
+};
+
+extern "C" {
+
+static void InlineJpegInitSource(j_decompress_ptr info) {
+}
+
+static boolean InlineJpegFillInputBuffer(j_decompress_ptr info) {
+	const auto source = reinterpret_cast<InlineJpegSource*>(info->src);
+	while (source->part < int(source->parts.size())
+		&& !source->parts[source->part].second) {
+		++source->part;
+	}
+	if (source->part < int(source->parts.size())) {
+		const auto &[data, size] = source->parts[source->part++];
+		source->manager.next_input_byte = data;
+		source->manager.bytes_in_buffer = size;
+	} else {
+		// Insert a fake EOI marker, the same way jpeg_mem_src() does.
+		static const JOCTET kEndOfImage[] = { 0xFF, JPEG_EOI };
+		source->manager.next_input_byte = kEndOfImage;
+		source->manager.bytes_in_buffer = 2;
+	}
+	return TRUE;
+}
+
+static void InlineJpegSkipInputData(j_decompress_ptr info, long count) {
+	const auto manager = info->src;
+	while (count > long(manager->bytes_in_buffer)) {
+		count -= long(manager->bytes_in_buffer);
+		manager->fill_input_buffer(info);
+	}
+	if (count > 0) {
+		manager->next_input_byte += size_t(count);
+		manager->bytes_in_buffer -= size_t(count);
+	}
+}
+
+static void InlineJpegTermSource(j_decompress_ptr info) {
+}
+
+} // extern "C"
+
+// Produces the same Format_RGB32 image as QImageReader for the expanded
+// inline bytes, but without building the full JPEG file.
+[[nodiscard]] QImage DecodeInlineJpeg(const QByteArray &bytes) {
+	Expects(bytes.size() >= 3);
+
+	auto source = InlineJpegSource();
+	memcpy(source.header.data(), kInlineJpegHeader, source.header.size());
+	source.header[kInlineJpegHeightIndex] = JOCTET(bytes[1]);
+	source.header[kInlineJpegWidthIndex] = JOCTET(bytes[2]);
+	source.parts = { {
+		{ source.header.data(), source.header.size() },
+		{
+			reinterpret_cast<const JOCTET*>(bytes.constData() + 3),
+			size_t(bytes.size() - 3),
+		},
+		{
+			reinterpret_cast<const JOCTET*>(kInlineJpegFooter),
+			sizeof(kInlineJpegFooter) - 1,
+		},
+	} };
+	source.manager.init_source = InlineJpegInitSource;
+	source.manager.fill_input_buffer = InlineJpegFillInputBuffer;
+	source.manager.skip_input_data = InlineJpegSkipInputData;
+	source.manager.resync_to_restart = jpeg_resync_to_restart;
+	source.manager.term_source = InlineJpegTermSource;
+
+	auto result = QImage();
+	struct jpeg_decompress_struct info;
+	struct my_error_mgr jerr;
+
+	info.err = jpeg_std_error(&jerr);
+	jerr.error_exit = my_error_exit;
+	if (setjmp(jerr.setjmp_buffer)) {
+		jpeg_destroy_decompress(&info);
+		return QImage();
+	}
+
+	jpeg_create_decompress(&info);
+	info.src = &source.manager;
+	if (jpeg_read_header(&info, TRUE) != JPEG_HEADER_OK
+		|| info.num_components != 3) {
+		jpeg_destroy_decompress(&info);
+		return QImage();
+	}
+#ifdef JCS_EXTENSIONS
+	info.out_color_space = (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
+		? JCS_EXT_BGRX
+		: JCS_EXT_XRGB;
+#else // JCS_EXTENSIONS
+	info.out_color_space = JCS_RGB;
+#endif // JCS_EXTENSIONS
+	jpeg_start_decompress(&info);
+
+	result = QImage(
+		int(info.output_width),
+		int(info.output_height),
+		QImage::Format_RGB32);
+	if (result.isNull()) {
+		jpeg_destroy_decompress(&info);
+		return QImage();
+	}
+	while (info.output_scanline < info.output_height) {
+		const auto line = result.scanLine(int(info.output_scanline));
+		auto row = reinterpret_cast<JSAMPROW>(line);
+		jpeg_read_scanlines(&info, &row, 1);
+#ifndef JCS_EXTENSIONS
+		// Expand RGB to RGB32 in place, from the end of the line.
+		auto pixels = reinterpret_cast<QRgb*>(line);
+		for (auto x = int(info.output_width); x != 0;) {
+			--x;
+			pixels[x] = qRgb(line[3 * x], line[3 * x + 1], line[3 * x + 2]);
+		}
+#endif // !JCS_EXTENSIONS
+	}
+	jpeg_finish_decompress(&info);
+	jpeg_destroy_decompress(&info);
+	return result;
+}
+
+// Reads the same characters ExpandPathInlineBytes() would produce,
+// one by one, without building the expanded string.
+class InlinePathReader final {
+public:
+	explicit InlinePathReader(const QByteArray &bytes)
+	: _bytes(bytes) {
+		_buffer[0] = 'M';
+		_count = 1;
+	}
+
+	[[nodiscard]] char current() const {
+		return (_offset < _count) ? _buffer[_offset] : '\0';
+	}
+	[[nodiscard]] int position() const {
+		return _position;
+	}
+	void next() {
+		if (_offset >= _count) {
+			return;
+		}
+		++_position;
+		if (++_offset == _count) {
+			fill();
+		}
+	}
+
+private:
+	void fill() {
+		_offset = _count = 0;
+		if (_index > _bytes.size()) {
+			return;
+		} else if (_index == _bytes.size()) {
+			++_index;
+			_buffer[_count++] = 'z';
+			return;
+		}
+		const auto c = uchar(_bytes[_index++]);
+		if (c >= 128 + 64) {
+			_buffer[_count++] = "AACAAAAHAAALMAAAQASTAVAAAZ"
+				"aacaaaahaaalmaaaqastava.az0123456789-,"[c - 128 - 64];
+			return;
+		} else if (c >= 128) {
+			_buffer[_count++] = ',';
+		} else if (c >= 64) {
+			_buffer[_count++] = '-';
+		}
+		const auto value = (c & 63);
+		if (value >= 10) {
+			_buffer[_count++] = char('0' + value / 10);
+		}
+		_buffer[_count++] = char('0' + value % 10);
+	}
+
+	const QByteArray &_bytes;
+	std::array<char, 4> _buffer = {};
+	int _index = 0;
+	int _offset = 0;
+	int _count = 0;
+	int _position = 0;
+
+};
+
 } // namespace
 
 QPixmap PixmapFast(QImage &&image) {
@@ -1396,53 +1628,31 @@ QByteArray ExpandInlineBytes(const QByteArray &bytes) {
 	if (bytes.size() < 3 || bytes[0] != '\x01') {
 		return QByteArray();
 	}
-	const char header[] = "\xff\xd8\xff\xe0\x00\x10\x4a\x46\x49"
-		"\x46\x00\x01\x01\x00\x00\x01\x00\x01\x00\x00\xff\xdb\x00\x43\x00\x28\x1c"
-		"\x1e\x23\x1e\x19\x28\x23\x21\x23\x2d\x2b\x28\x30\x3c\x64\x41\x3c\x37\x37"
-		"\x3c\x7b\x58\x5d\x49\x64\x91\x80\x99\x96\x8f\x80\x8c\x8a\xa0\xb4\xe6\xc3"
-		"\xa0\xaa\xda\xad\x8a\x8c\xc8\xff\xcb\xda\xee\xf5\xff\xff\xff\x9b\xc1\xff"
-		"\xff\xff\xfa\xff\xe6\xfd\xff\xf8\xff\xdb\x00\x43\x01\x2b\x2d\x2d\x3c\x35"
-		"\x3c\x76\x41\x41\x76\xf8\xa5\x8c\xa5\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8"
-		"\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8"
-		"\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8\xf8"
-		"\xf8\xf8\xf8\xf8\xf8\xff\xc0\x00\x11\x08\x00\x00\x00\x00\x03\x01\x22\x00"
-		"\x02\x11\x01\x03\x11\x01\xff\xc4\x00\x1f\x00\x00\x01\x05\x01\x01\x01\x01"
-		"\x01\x01\x00\x00\x00\x00\x00\x00\x00\x00\x01\x02\x03\x04\x05\x06\x07\x08"
-		"\x09\x0a\x0b\xff\xc4\x00\xb5\x10\x00\x02\x01\x03\x03\x02\x04\x03\x05\x05"
-		"\x04\x04\x00\x00\x01\x7d\x01\x02\x03\x00\x04\x11\x05\x12\x21\x31\x41\x06"
-		"\x13\x51\x61\x07\x22\x71\x14\x32\x81\x91\xa1\x08\x23\x42\xb1\xc1\x15\x52"
-		"\xd1\xf0\x24\x33\x62\x72\x82\x09\x0a\x16\x17\x18\x19\x1a\x25\x26\x27\x28"
-		"\x29\x2a\x34\x35\x36\x37\x38\x39\x3a\x43\x44\x45\x46\x47\x48\x49\x4a\x53"
-		"\x54\x55\x56\x57\x58\x59\x5a\x63\x64\x65\x66\x67\x68\x69\x6a\x73\x74\x75"
-		"\x76\x77\x78\x79\x7a\x83\x84\x85\x86\x87\x88\x89\x8a\x92\x93\x94\x95\x96"
-		"\x97\x98\x99\x9a\xa2\xa3\xa4\xa5\xa6\xa7\xa8\xa9\xaa\xb2\xb3\xb4\xb5\xb6"
-		"\xb7\xb8\xb9\xba\xc2\xc3\xc4\xc5\xc6\xc7\xc8\xc9\xca\xd2\xd3\xd4\xd5\xd6"
-		"\xd7\xd8\xd9\xda\xe1\xe2\xe3\xe4\xe5\xe6\xe7\xe8\xe9\xea\xf1\xf2\xf3\xf4"
-		"\xf5\xf6\xf7\xf8\xf9\xfa\xff\xc4\x00\x1f\x01\x00\x03\x01\x01\x01\x01\x01"
-		"\x01\x01\x01\x01\x00\x00\x00\x00\x00\x00\x01\x02\x03\x04\x05\x06\x07\x08"
-		"\x09\x0a\x0b\xff\xc4\x00\xb5\x11\x00\x02\x01\x02\x04\x04\x03\x04\x07\x05"
-		"\x04\x04\x00\x01\x02\x77\x00\x01\x02\x03\x11\x04\x05\x21\x31\x06\x12\x41"
-		"\x51\x07\x61\x71\x13\x22\x32\x81\x08\x14\x42\x91\xa1\xb1\xc1\x09\x23\x33"
-		"\x52\xf0\x15\x62\x72\xd1\x0a\x16\x24\x34\xe1\x25\xf1\x17\x18\x19\x1a\x26"
-		"\x27\x28\x29\x2a\x35\x36\x37\x38\x39\x3a\x43\x44\x45\x46\x47\x48\x49\x4a"
-		"\x53\x54\x55\x56\x57\x58\x59\x5a\x63\x64\x65\x66\x67\x68\x69\x6a\x73\x74"
-		"\x75\x76\x77\x78\x79\x7a\x82\x83\x84\x85\x86\x87\x88\x89\x8a\x92\x93\x94"
-		"\x95\x96\x97\x98\x99\x9a\xa2\xa3\xa4\xa5\xa6\xa7\xa8\xa9\xaa\xb2\xb3\xb4"
-		"\xb5\xb6\xb7\xb8\xb9\xba\xc2\xc3\xc4\xc5\xc6\xc7\xc8\xc9\xca\xd2\xd3\xd4"
-		"\xd5\xd6\xd7\xd8\xd9\xda\xe2\xe3\xe4\xe5\xe6\xe7\xe8\xe9\xea\xf2\xf3\xf4"
-		"\xf5\xf6\xf7\xf8\xf9\xfa\xff\xda\x00\x0c\x03\x01\x00\x02\x11\x03\x11\x00"
-		"\x3f\x00";
-	const char footer[] = "\xff\xd9";
-	auto real = QByteArray(header, sizeof(header) - 1);
-	real[164] = bytes[1];
-	real[166] = bytes[2];
+	auto real = QByteArray(kInlineJpegHeader, sizeof(kInlineJpegHeader) - 1);
+	real[kInlineJpegHeightIndex] = bytes[1];
+	real[kInlineJpegWidthIndex] = bytes[2];
 	return real
 		+ bytes.mid(3)
-		+ QByteArray::fromRawData(footer, sizeof(footer) - 1);
+		+ QByteArray::fromRawData(
+			kInlineJpegFooter,
+			sizeof(kInlineJpegFooter) - 1);
 }
 
 QImage FromInlineBytes(const QByteArray &bytes) {
-	return Read({ .content = ExpandInlineBytes(bytes) }).image;
+	if (bytes.size() < 3 || bytes[0] != '\x01') {
+		return QImage();
+	}
+	auto result = DecodeInlineJpeg(bytes);
+	if (result.isNull()) {
+		return Read({ .content = ExpandInlineBytes(bytes) }).image;
+	}
+#ifdef _DEBUG
+	// The direct decoding must give exactly the same pixels.
+	const auto expected = Read({ .content = ExpandInlineBytes(bytes) }).image;
+	Assert(expected.isNull()
+		|| expected.convertToFormat(result.format()) == result);
+#endif // _DEBUG
+	return result;
 }
 
 // Thanks TDLib for code.
@@ -1474,9 +1684,18 @@ QPainterPath PathFromInlineBytes(const QByteArray &bytes) {
 	if (bytes.isEmpty()) {
 		return QPainterPath();
 	}
-	const auto expanded = ExpandPathInlineBytes(bytes);
-	const auto path = expanded.data(); // Allows checking for '\0' by index.
-	auto position = 0;
+	auto path = InlinePathReader(bytes);
+
+#ifdef _DEBUG
+	// The reader must give exactly the same characters.
+	auto check = InlinePathReader(bytes);
+	auto expanded = QByteArray();
+	while (check.current() != '\0') {
+		expanded.append(check.current());
+		check.next();
+	}
+	Assert(expanded == ExpandPathInlineBytes(bytes));
+#endif // _DEBUG
 
 	const auto isAlpha = [](char c) {
 		c |= 0x20;
@@ -1486,28 +1705,29 @@ QPainterPath PathFromInlineBytes(const QByteArray &bytes) {
 		return '0' <= c && c <= '9';
 	};
 	const auto skipCommas = [&] {
-		while (path[position] == ',') {
-			++position;
+		while (path.current() == ',') {
+			path.next();
 		}
 	};
 	const auto getNumber = [&] {
 		skipCommas();
 		auto sign = 1;
-		if (path[position] == '-') {
+		if (path.current() == '-') {
 			sign = -1;
-			++position;
+			path.next();
 		}
 		double res = 0;
-		while (isDigit(path[position])) {
-			res = res * 10 + path[position++] - '0';
+		while (isDigit(path.current())) {
+			res = res * 10 + path.current() - '0';
+			path.next();
 		}
-		if (path[position] == '.') {
-			++position;
+		if (path.current() == '.') {
+			path.next();
 			double mul = 0.1;
-			while (isDigit(path[position])) {
-				res += (path[position] - '0') * mul;
+			while (isDigit(path.current())) {
+				res += (path.current() - '0') * mul;
 				mul *= 0.1;
-				++position;
+				path.next();
 			}
 		}
 		return sign * res;
@@ -1516,14 +1736,15 @@ QPainterPath PathFromInlineBytes(const QByteArray &bytes) {
 	auto result = QPainterPath();
 	auto x = 0.;
 	auto y = 0.;
-	while (path[position] != '\0') {
+	while (path.current() != '\0') {
 		skipCommas();
-		if (path[position] == '\0') {
+		if (path.current() == '\0') {
 			break;
 		}
 
-		while (path[position] == 'm' || path[position] == 'M') {
-			auto command = path[position++];
+		while (path.current() == 'm' || path.current() == 'M') {
+			auto command = path.current();
+			path.next();
 			do {
 				if (command == 'm') {
 					x += getNumber();
@@ -1533,7 +1754,7 @@ QPainterPath PathFromInlineBytes(const QByteArray &bytes) {
 					y = getNumber();
 				}
 				skipCommas();
-			} while (path[position] != '\0' && !isAlpha(path[position]));
+			} while (path.current() != '\0' && !isAlpha(path.current()));
 		}
 
 		auto xStart = x;
@@ -1546,13 +1767,17 @@ QPainterPath PathFromInlineBytes(const QByteArray &bytes) {
 		auto command = '-';
 		while (!isClosed) {
 			skipCommas();
-			if (path[position] == '\0') {
+			if (path.current() == '\0') {
 				LOG(("SVG Error: Receive unclosed path: %1"
-					).arg(QString::fromLatin1(path)));
+					).arg(QString::fromLatin1(ExpandPathInlineBytes(bytes))));
 				return QPainterPath();
 			}
-			if (isAlpha(path[position])) {
-				command = path[position++];
+			if (isAlpha(path.current())) {
+				// The 'm' command is read again by the outer loop.
+				command = path.current();
+				if (command != 'm' && command != 'M') {
+					path.next();
+				}
 			}
 			switch (command) {
 			case 'l':
@@ -1623,8 +1848,6 @@ QPainterPath PathFromInlineBytes(const QByteArray &bytes) {
 			}
 			case 'm':
 			case 'M':
-				--position;
-				[[fallthrough]];
 			case 'z':
 			case 'Z':
 				if (x != xStart || y != yStart) {
@@ -1637,8 +1860,8 @@ QPainterPath PathFromInlineBytes(const QByteArray &bytes) {
 			default:
 				LOG(("SVG Error: Receive invalid command %1 at pos %2: %3"
 					).arg(command
-					).arg(position
-					).arg(QString::fromLatin1(path)));
+					).arg(path.position()
+					).arg(QString::fromLatin1(ExpandPathInlineBytes(bytes))));
 				return QPainterPath();
 			}
 		}
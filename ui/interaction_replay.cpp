@@ -0,0 +1,207 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/interaction_replay.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QtEvents>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QWidget>
+
+namespace Ui {
+namespace {
+
+class FrameCounter final : public QObject {
+public:
+	explicit FrameCounter(not_null<ReplayFrame*> frame) : _frame(frame) {
+		QCoreApplication::instance()->installEventFilter(this);
+	}
+	~FrameCounter() {
+		QCoreApplication::instance()->removeEventFilter(this);
+	}
+
+protected:
+	bool eventFilter(QObject *o, QEvent *e) override {
+		switch (e->type()) {
+		case QEvent::Paint: ++_frame->paints; break;
+		case QEvent::Resize: ++_frame->resizes; break;
+		case QEvent::LayoutRequest: ++_frame->layoutRequests; break;
+		}
+		return false;
+	}
+
+private:
+	const not_null<ReplayFrame*> _frame;
+
+};
+
+[[nodiscard]] not_null<QWidget*> ResolveTarget(
+		not_null<QWidget*> root,
+		const ReplayStep &step) {
+	if (step.type == ReplayStep::Type::KeyPress
+		|| step.type == ReplayStep::Type::KeyRelease) {
+		if (const auto focused = QApplication::focusWidget()) {
+			if (focused == root || root->isAncestorOf(focused)) {
+				return focused;
+			}
+		}
+		return root;
+	} else if (const auto child = root->childAt(step.position)) {
+		return child;
+	}
+	return root;
+}
+
+void SendStep(
+		not_null<QWidget*> root,
+		const ReplayStep &step,
+		Qt::MouseButtons &buttons) {
+	using Type = ReplayStep::Type;
+	const auto target = ResolveTarget(root, step);
+	const auto local = QPointF(target->mapFrom(root, step.position));
+	const auto global = QPointF(root->mapToGlobal(step.position));
+	const auto window = QPointF(target->window()->mapFromGlobal(
+		global.toPoint()));
+	switch (step.type) {
+	case Type::MouseMove:
+	case Type::MousePress:
+	case Type::MouseRelease: {
+		if (step.type == Type::MousePress) {
+			buttons |= step.button;
+		} else if (step.type == Type::MouseRelease) {
+			buttons &= ~Qt::MouseButtons(step.button);
+		}
+		const auto type = (step.type == Type::MousePress)
+			? QEvent::MouseButtonPress
+			: (step.type == Type::MouseRelease)
+			? QEvent::MouseButtonRelease
+			: QEvent::MouseMove;
+		auto event = QMouseEvent(
+			type,
+			local,
+			window,
+			global,
+			(step.type == Type::MouseMove) ? Qt::NoButton : step.button,
+			buttons,
+			step.modifiers);
+		QCoreApplication::sendEvent(target, &event);
+	} break;
+	case Type::Wheel: {
+		auto event = QWheelEvent(
+			local,
+			global,
+			QPoint(),
+			step.angleDelta,
+			buttons,
+			step.modifiers,
+			Qt::NoScrollPhase,
+			false);
+		QCoreApplication::sendEvent(target, &event);
+	} break;
+	case Type::KeyPress:
+	case Type::KeyRelease: {
+		auto event = QKeyEvent(
+			((step.type == Type::KeyPress)
+				? QEvent::KeyPress
+				: QEvent::KeyRelease),
+			step.key,
+			step.modifiers,
+			step.text);
+		QCoreApplication::sendEvent(target, &event);
+	} break;
+	}
+}
+
+} // namespace
+
+ReplayRecorder::ReplayRecorder(not_null<QWidget*> root)
+: _root(root)
+, _started(crl::now()) {
+	QCoreApplication::instance()->installEventFilter(this);
+}
+
+const std::vector<ReplayStep> &ReplayRecorder::steps() const {
+	return _steps;
+}
+
+bool ReplayRecorder::eventFilter(QObject *o, QEvent *e) {
+	using Type = ReplayStep::Type;
+
+	const auto widget = qobject_cast<QWidget*>(o);
+	if (!widget || (widget != _root && !_root->isAncestorOf(widget))) {
+		return false;
+	}
+	const auto position = [&](QPointF local) {
+		return widget->mapTo(_root, local.toPoint());
+	};
+	auto step = ReplayStep{ .at = crl::now() - _started };
+	switch (e->type()) {
+	case QEvent::MouseMove:
+	case QEvent::MouseButtonPress:
+	case QEvent::MouseButtonRelease: {
+		const auto mouse = static_cast<QMouseEvent*>(e);
+		step.type = (e->type() == QEvent::MouseButtonPress)
+			? Type::MousePress
+			: (e->type() == QEvent::MouseButtonRelease)
+			? Type::MouseRelease
+			: Type::MouseMove;
+		step.position = position(mouse->pos());
+		step.button = mouse->button();
+		step.modifiers = mouse->modifiers();
+	} break;
+	case QEvent::Wheel: {
+		const auto wheel = static_cast<QWheelEvent*>(e);
+		step.type = Type::Wheel;
+		step.position = position(wheel->position());
+		step.angleDelta = wheel->angleDelta();
+		step.modifiers = wheel->modifiers();
+	} break;
+	case QEvent::KeyPress:
+	case QEvent::KeyRelease: {
+		const auto key = static_cast<QKeyEvent*>(e);
+		step.type = (e->type() == QEvent::KeyPress)
+			? Type::KeyPress
+			: Type::KeyRelease;
+		step.key = key->key();
+		step.modifiers = key->modifiers();
+		step.text = key->text();
+	} break;
+	default: return false;
+	}
+	// The same event may be propagated to the parents, record it once.
+	const auto timestamp = static_cast<QInputEvent*>(e)->timestamp();
+	if (!e->spontaneous()
+		|| (e == _lastEvent && timestamp == _lastTimestamp)) {
+		return false;
+	}
+	_lastEvent = e;
+	_lastTimestamp = timestamp;
+	_steps.push_back(std::move(step));
+	return false;
+}
+
+std::vector<ReplayFrame> ReplayInteraction(
+		not_null<QWidget*> root,
+		const std::vector<ReplayStep> &steps) {
+	auto result = std::vector<ReplayFrame>();
+	result.reserve(steps.size());
+	auto buttons = Qt::MouseButtons();
+	auto timer = QElapsedTimer();
+	for (const auto &step : steps) {
+		auto &frame = result.emplace_back(ReplayFrame{ .at = step.at });
+		const auto counter = FrameCounter(&frame);
+		timer.start();
+		SendStep(root, step, buttons);
+
+		// Delivers layout requests and the window update request.
+		QCoreApplication::sendPostedEvents();
+		frame.microseconds = timer.nsecsElapsed() / 1000;
+	}
+	return result;
+}
+
+} // namespace Ui
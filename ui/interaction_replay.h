@@ -0,0 +1,73 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "base/basic_types.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QPoint>
+
+class QWidget;
+
+namespace Ui {
+
+struct ReplayStep {
+	enum class Type : uchar {
+		MouseMove,
+		MousePress,
+		MouseRelease,
+		Wheel,
+		KeyPress,
+		KeyRelease,
+	};
+	Type type = Type::MouseMove;
+	crl::time at = 0; // Since the script start.
+	QPoint position; // In the root widget coordinates.
+	QPoint angleDelta;
+	Qt::MouseButton button = Qt::NoButton;
+	Qt::KeyboardModifiers modifiers;
+	int key = 0;
+	QString text;
+};
+
+struct ReplayFrame {
+	crl::time at = 0;
+	int64 microseconds = 0; // Handling the step and the following paints.
+	int paints = 0;
+	int resizes = 0;
+	int layoutRequests = 0;
+};
+
+// Records mouse, wheel and key events delivered inside the root widget.
+class ReplayRecorder final : public QObject {
+public:
+	explicit ReplayRecorder(not_null<QWidget*> root);
+
+	[[nodiscard]] const std::vector<ReplayStep> &steps() const;
+
+protected:
+	bool eventFilter(QObject *o, QEvent *e) override;
+
+private:
+	const not_null<QWidget*> _root;
+	const crl::time _started = 0;
+	std::vector<ReplayStep> _steps;
+	const QEvent *_lastEvent = nullptr;
+	ulong _lastTimestamp = 0;
+
+};
+
+// Sends the recorded events to the widgets under the root one by one,
+// processing the resulting paints and layout after each of them.
+//
+// Steps are replayed back to back, their recorded time is only reported,
+// so running animations advance by the real time spent in the replay.
+[[nodiscard]] std::vector<ReplayFrame> ReplayInteraction(
+	not_null<QWidget*> root,
+	const std::vector<ReplayStep> &steps);
+
+} // namespace Ui
@@ -8,6 +8,7 @@
 
 #include "base/integration.h"
 #include "ui/platform/ui_platform_utility.h"
+#include "ui/stall_watchdog.h"
 
 #include <QtCore/QMutex>
 #include <QtCore/QCoreApplication>
@@ -67,6 +68,7 @@ void DrainMainQueueGeneric() {
 	const auto argument = MainQueueProcessArgument;
 	MainQueueProcessState.store(ProcessState::Processed);
 
+	const auto watch = StallScope(StallCategory::MainQueue);
 	callback(argument);
 }
 
@@ -79,6 +81,7 @@ MainQueueProcessor::MainQueueProcessor() {
 	} else {
 		crl::wrap_main_queue([](void (*callable)(void*), void *argument) {
 			base::Integration::Instance().enterFromEventLoop([&] {
+				const auto watch = StallScope(StallCategory::MainQueue);
 				callable(argument);
 			});
 		});
@@ -13,6 +13,11 @@
 #include <QPainterPath>
 
 namespace Ui {
+namespace {
+
+auto RoundRectCornersBytes = std::atomic<int64>();
+
+} // namespace
 
 QPainterPath ComplexRoundedRectPath(
 		const QRect &rect,
@@ -128,7 +133,9 @@ RoundRect::RoundRect(
 	ImageRoundRadius radius,
 	const style::color &color)
 : _color(color)
-, _refresh([=] { _corners = Images::PrepareCorners(radius, _color); }) {
+, _cornersBytes(&RoundRectCornersBytes)
+, _refresh([=] { refresh(Images::PrepareCorners(radius, _color)); }) {
+	RegisterReportedCache(u"round corners"_q, &RoundRectCornersBytes);
 	_refresh();
 	style::PaletteChanged(
 	) | rpl::on_next(_refresh, _lifetime);
@@ -138,12 +145,23 @@ RoundRect::RoundRect(
 	int radius,
 	const style::color &color)
 : _color(color)
-, _refresh([=] { _corners = Images::PrepareCorners(radius, _color); }) {
+, _cornersBytes(&RoundRectCornersBytes)
+, _refresh([=] { refresh(Images::PrepareCorners(radius, _color)); }) {
+	RegisterReportedCache(u"round corners"_q, &RoundRectCornersBytes);
 	_refresh();
 	style::PaletteChanged(
 	) | rpl::on_next(_refresh, _lifetime);
 }
 
+void RoundRect::refresh(std::array<QImage, 4> corners) {
+	_corners = std::move(corners);
+	auto bytes = int64();
+	for (const auto &corner : _corners) {
+		bytes += corner.sizeInBytes();
+	}
+	_cornersBytes.set(bytes);
+}
+
 void RoundRect::setColor(const style::color &color) {
 	_color = color;
 	_refresh();
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "ui/cache_registry.h"
 #include "ui/rect_part.h"
 #include "ui/style/style_core.h"
 
@@ -45,8 +46,11 @@ public:
 		RectParts corners) const;
 
 private:
+	void refresh(std::array<QImage, 4> corners);
+
 	style::color _color;
 	std::array<QImage, 4> _corners;
+	ReportedCacheBytes _cornersBytes;
 	Fn<void()> _refresh;
 
 	rpl::lifetime _lifetime;
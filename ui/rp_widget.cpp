@@ -7,10 +7,15 @@
 #include "ui/rp_widget.h"
 
 #include "base/platform/base_platform_info.h"
+#include "base/flat_map.h"
 #include "base/qt_signal_producer.h"
 #include "ui/accessible/ui_accessible_item.h"
 #include "ui/accessible/ui_accessible_widget.h"
 #include "ui/gl/gl_detection.h"
+#include "ui/stall_watchdog.h"
+#include "ui/ui_utility.h"
+
+#include <crl/crl_on_main.h>
 
 #include <QtGui/QWindow>
 #include <QtGui/QtEvents>
@@ -34,6 +39,115 @@ namespace {
 	return result;
 }
 
+struct AccessibilityNotification {
+	QPointer<RpWidget> widget;
+	QAccessible::Event type = QAccessible::InvalidEvent;
+	int child = -1;
+	AccessibilityState changes;
+};
+
+using AccessibilityNotificationKey = std::tuple<
+	const RpWidget*,
+	int,
+	QAccessible::Event>;
+
+// Notifications are sent once per event loop iteration, duplicates of
+// the same event for the same widget and child are collapsed together.
+auto AccessibilityQueue = std::vector<AccessibilityNotification>();
+auto AccessibilityQueueIndices = base::flat_map<
+	AccessibilityNotificationKey,
+	int>();
+auto AccessibilityFlushScheduled = false;
+
+void MergeAccessibilityState(
+		AccessibilityState &to,
+		AccessibilityState from) {
+	to.checkable = to.checkable || from.checkable;
+	to.checked = to.checked || from.checked;
+	to.extSelectable = to.extSelectable || from.extSelectable;
+	to.multiSelectable = to.multiSelectable || from.multiSelectable;
+	to.pressed = to.pressed || from.pressed;
+	to.readOnly = to.readOnly || from.readOnly;
+	to.selectable = to.selectable || from.selectable;
+	to.selected = to.selected || from.selected;
+}
+
+void SendAccessibilityNotification(
+		const AccessibilityNotification &notification) {
+	const auto widget = notification.widget.data();
+	if (!widget) {
+		return;
+	}
+	const auto child = notification.child;
+	if (notification.type == QAccessible::StateChanged) {
+		auto fields = QAccessible::State();
+		auto changes = notification.changes;
+		changes.writeTo(fields);
+		QAccessibleStateChangeEvent event(widget, fields);
+		if (child >= 0) {
+			event.setChild(child);
+		}
+		QAccessible::updateAccessibility(&event);
+	} else if (notification.type == QAccessible::ValueChanged
+		&& child < 0) {
+		// The value is read only now, so the latest one is reported.
+		QAccessibleValueChangeEvent event(
+			widget,
+			widget->accessibilityValue());
+		QAccessible::updateAccessibility(&event);
+	} else {
+		QAccessibleEvent event(widget, notification.type);
+		if (child >= 0) {
+			event.setChild(child);
+		}
+		QAccessible::updateAccessibility(&event);
+	}
+}
+
+void FlushAccessibilityNotifications() {
+	AccessibilityFlushScheduled = false;
+	AccessibilityQueueIndices.clear();
+	const auto queue = base::take(AccessibilityQueue);
+	if (!QAccessible::isActive()) {
+		return;
+	}
+	for (const auto &notification : queue) {
+		SendAccessibilityNotification(notification);
+	}
+}
+
+void QueueAccessibilityNotification(
+		not_null<RpWidget*> widget,
+		QAccessible::Event type,
+		int child = -1,
+		AccessibilityState changes = {}) {
+	if (!QAccessible::isActive()) {
+		return;
+	}
+	const auto key = AccessibilityNotificationKey{ widget, child, type };
+	const auto i = AccessibilityQueueIndices.find(key);
+	if (i != end(AccessibilityQueueIndices)) {
+		auto &notification = AccessibilityQueue[i->second];
+		if (!notification.widget) {
+			// A new widget was created at the address of a destroyed one.
+			notification.widget = widget.get();
+		}
+		MergeAccessibilityState(notification.changes, changes);
+		return;
+	}
+	AccessibilityQueueIndices.emplace(key, int(AccessibilityQueue.size()));
+	AccessibilityQueue.push_back({
+		.widget = widget.get(),
+		.type = type,
+		.child = child,
+		.changes = changes,
+	});
+	if (!AccessibilityFlushScheduled) {
+		AccessibilityFlushScheduled = true;
+		crl::on_main(FlushAccessibilityNotifications);
+	}
+}
+
 } // namespace
 
 void ToggleChildrenVisibility(not_null<QWidget*> widget, bool visible) {
@@ -210,6 +324,21 @@ rpl::lifetime &RpWidgetWrap::lifetime() {
 bool RpWidgetWrap::handleEvent(QEvent *event) {
 	Expects(event != nullptr);
 
+	const auto type = event->type();
+	const auto watch = StallScope(
+		(type == QEvent::Paint) ? StallCategory::Paint : StallCategory::Event,
+		rpWidget(),
+		int(type));
+
+	if (type == QEvent::ChildAdded) {
+		const auto child = static_cast<QChildEvent*>(event)->child();
+		if (child->isWidgetType()) {
+			MarkPendingMoveResize(static_cast<QWidget*>(child));
+		}
+	} else if (type == QEvent::HideToParent) {
+		MarkPendingMoveResize(rpWidget());
+	}
+
 	auto streams = _eventStreams.get();
 	if (!streams) {
 		return eventHook(event);
@@ -424,34 +553,34 @@ QString RpWidget::accessibilityChildSubItemValue(int row, int column) const {
 }
 
 void RpWidget::accessibilityChildNameChanged(int index) {
-	QAccessibleEvent event(this, QAccessible::NameChanged);
-	event.setChild(index);
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(this, QAccessible::NameChanged, index);
 }
 
 void RpWidget::accessibilityChildDescriptionChanged(int index) {
-	QAccessibleEvent event(this, QAccessible::DescriptionChanged);
-	event.setChild(index);
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(
+		this,
+		QAccessible::DescriptionChanged,
+		index);
 }
 
 void RpWidget::accessibilityChildValueChanged(int index) {
-	QAccessibleEvent event(this, QAccessible::ValueChanged);
-	event.setChild(index);
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(this, QAccessible::ValueChanged, index);
 }
 
 void RpWidget::accessibilityChildStateChanged(
 		int index,
 		AccessibilityState changes) {
-	auto fields = QAccessible::State();
-	changes.writeTo(fields);
-	QAccessibleStateChangeEvent event(this, fields);
-	event.setChild(index);
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(
+		this,
+		QAccessible::StateChanged,
+		index,
+		changes);
 }
 
 void RpWidget::accessibilityChildFocused(int index) {
+	// Focus is reported right away, after the changes that came before it.
+	FlushAccessibilityNotifications();
+
 	QAccessibleEvent event(this, QAccessible::Focus);
 	event.setChild(index);
 	QAccessible::updateAccessibility(&event);
@@ -480,8 +609,7 @@ QString RpWidget::accessibilityName() {
 }
 
 void RpWidget::accessibilityNameChanged() {
-	QAccessibleEvent event(this, QAccessible::NameChanged);
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(this, QAccessible::NameChanged);
 }
 
 QString RpWidget::accessibilityDescription() {
@@ -489,8 +617,7 @@ QString RpWidget::accessibilityDescription() {
 }
 
 void RpWidget::accessibilityDescriptionChanged() {
-	QAccessibleEvent event(this, QAccessible::DescriptionChanged);
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(this, QAccessible::DescriptionChanged);
 }
 
 AccessibilityState RpWidget::accessibilityState() const {
@@ -498,10 +625,11 @@ AccessibilityState RpWidget::accessibilityState() const {
 }
 
 void RpWidget::accessibilityStateChanged(AccessibilityState changes) {
-	auto fields = QAccessible::State();
-	changes.writeTo(fields);
-	QAccessibleStateChangeEvent event(this, fields);
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(
+		this,
+		QAccessible::StateChanged,
+		-1,
+		changes);
 }
 
 QString RpWidget::accessibilityValue() const {
@@ -509,8 +637,7 @@ QString RpWidget::accessibilityValue() const {
 }
 
 void RpWidget::accessibilityValueChanged() {
-	QAccessibleValueChangeEvent event(this, accessibilityValue());
-	QAccessible::updateAccessibility(&event);
+	QueueAccessibilityNotification(this, QAccessible::ValueChanged);
 }
 
 QStringList RpWidget::accessibilityActionNames() {
@@ -528,6 +655,10 @@ std::vector<not_null<QWidget*>> RpWidget::accessibilityChildWidgets() const {
 	return {};
 }
 
+void RpWidget::accessibilityChildrenReordered() {
+	QueueAccessibilityNotification(this, QAccessible::ObjectReorder);
+}
+
 std::optional<Qt::Orientation> RpWidget::accessibilityOrientation() const {
 	return std::nullopt;
 }
@@ -423,6 +423,7 @@ public:
 	// the QObject child order (e.g. a reorderable VerticalLayout). Empty means
 	// use the default QWidget enumeration.
 	[[nodiscard]] virtual std::vector<not_null<QWidget*>> accessibilityChildWidgets() const;
+	void accessibilityChildrenReordered();
 
 	// Orientation of an ordered container (e.g. a list), exposed to UIA so a
 	// screen reader can announce a horizontal/vertical arrangement. nullopt (the
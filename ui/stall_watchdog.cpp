@@ -0,0 +1,154 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/stall_watchdog.h"
+
+#include "base/debug_log.h"
+
+#include <QtCore/QObject>
+
+#include <rpl/event_stream.h>
+
+#include <deque>
+
+namespace Ui {
+namespace {
+
+constexpr auto kDefaultThreshold = crl::time(100);
+constexpr auto kRecentStallsLimit = 64;
+
+struct WatchdogState {
+	std::array<StallHistogram, kStallCategoriesCount> histograms;
+	std::deque<StallReport> recent;
+	rpl::event_stream<StallReport> stalls;
+	crl::time threshold = kDefaultThreshold;
+	uint64 reported = 0;
+	bool enabled = true;
+};
+
+[[nodiscard]] WatchdogState &State() {
+	static auto result = WatchdogState();
+	return result;
+}
+
+[[nodiscard]] int BucketIndex(crl::time duration) {
+	auto result = 0;
+	while (duration > 0 && result + 1 < StallHistogram::kBuckets) {
+		duration >>= 1;
+		++result;
+	}
+	return result;
+}
+
+[[nodiscard]] const char *CategoryName(StallCategory category) {
+	switch (category) {
+	case StallCategory::MainQueue: return "main queue";
+	case StallCategory::Animations: return "animations";
+	case StallCategory::Paint: return "paint";
+	case StallCategory::Event: return "event";
+	}
+	Unexpected("Category in Ui::CategoryName.");
+}
+
+void Report(StallReport report) {
+	auto &state = State();
+	++state.reported;
+	DEBUG_LOG(("Stall: %1ms in %2 (%3, event %4).").arg(
+		QString::number(report.duration),
+		CategoryName(report.category),
+		report.className ? report.className : "-",
+		QString::number(report.eventType)));
+	state.recent.push_back(report);
+	if (state.recent.size() > kRecentStallsLimit) {
+		state.recent.pop_front();
+	}
+	state.stalls.fire(std::move(report));
+}
+
+} // namespace
+
+StallScope::StallScope(
+		StallCategory category,
+		const QObject *object,
+		int eventType) {
+	const auto &state = State();
+	if (!state.enabled) {
+		return;
+	}
+	_active = true;
+	_category = category;
+	_eventType = eventType;
+	_reportedBefore = state.reported;
+	// The object may be destroyed while handling the event.
+	_className = object ? object->metaObject()->className() : nullptr;
+	_started = crl::now();
+}
+
+StallScope::~StallScope() {
+	if (!_active) {
+		return;
+	}
+	auto &state = State();
+	const auto now = crl::now();
+	const auto duration = now - _started;
+
+	auto &histogram = state.histograms[int(_category)];
+	++histogram.buckets[BucketIndex(duration)];
+	++histogram.count;
+	histogram.total += duration;
+	histogram.maximum = std::max(histogram.maximum, duration);
+
+	if (state.enabled
+		&& duration >= state.threshold
+		&& state.reported == _reportedBefore) {
+		Report({
+			.category = _category,
+			.className = _className,
+			.eventType = _eventType,
+			.duration = duration,
+			.finished = now,
+		});
+	}
+}
+
+void SetStallWatchdogEnabled(bool enabled) {
+	State().enabled = enabled;
+}
+
+bool StallWatchdogEnabled() {
+	return State().enabled;
+}
+
+void SetStallThreshold(crl::time threshold) {
+	Expects(threshold > 0);
+
+	State().threshold = threshold;
+}
+
+crl::time StallThreshold() {
+	return State().threshold;
+}
+
+StallHistogram StallHistogramFor(StallCategory category) {
+	return State().histograms[int(category)];
+}
+
+std::vector<StallReport> RecentStalls() {
+	const auto &recent = State().recent;
+	return { begin(recent), end(recent) };
+}
+
+rpl::producer<StallReport> Stalls() {
+	return State().stalls.events();
+}
+
+void ResetStallStatistics() {
+	auto &state = State();
+	state.histograms = {};
+	state.recent.clear();
+}
+
+} // namespace Ui
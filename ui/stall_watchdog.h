@@ -0,0 +1,79 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "base/basic_types.h"
+
+#include <rpl/producer.h>
+
+class QObject;
+
+namespace Ui {
+
+enum class StallCategory : uchar {
+	MainQueue,
+	Animations,
+	Paint,
+	Event,
+};
+inline constexpr auto kStallCategoriesCount = 4;
+
+struct StallReport {
+	StallCategory category = StallCategory();
+	const char *className = nullptr; // Of the widget handling the event.
+	int eventType = 0;
+	crl::time duration = 0;
+	crl::time finished = 0;
+};
+
+struct StallHistogram {
+	// First bucket counts durations below 1ms,
+	// bucket i > 0 counts durations in [2^(i-1), 2^i) ms,
+	// the last one counts everything longer.
+	static constexpr auto kBuckets = 13;
+
+	std::array<uint64, kBuckets> buckets = {};
+	uint64 count = 0;
+	crl::time total = 0;
+	crl::time maximum = 0;
+};
+
+// Measures main thread work in its lifetime, main thread only.
+// For nested scopes only the innermost one exceeding the threshold
+// is reported as a stall, but all of them go to the histograms.
+class StallScope final {
+public:
+	explicit StallScope(
+		StallCategory category,
+		const QObject *object = nullptr,
+		int eventType = 0);
+	StallScope(const StallScope &other) = delete;
+	StallScope &operator=(const StallScope &other) = delete;
+	~StallScope();
+
+private:
+	crl::time _started = 0;
+	const char *_className = nullptr;
+	uint64 _reportedBefore = 0;
+	int _eventType = 0;
+	StallCategory _category = StallCategory();
+	bool _active = false;
+
+};
+
+void SetStallWatchdogEnabled(bool enabled);
+[[nodiscard]] bool StallWatchdogEnabled();
+
+void SetStallThreshold(crl::time threshold);
+[[nodiscard]] crl::time StallThreshold();
+
+[[nodiscard]] StallHistogram StallHistogramFor(StallCategory category);
+[[nodiscard]] std::vector<StallReport> RecentStalls();
+[[nodiscard]] rpl::producer<StallReport> Stalls();
+void ResetStallStatistics();
+
+} // namespace Ui
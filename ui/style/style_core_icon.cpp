@@ -8,6 +8,7 @@
 
 #include "ui/style/style_core_palette.h"
 #include "ui/style/style_core.h"
+#include "ui/cache_registry.h"
 #include "ui/painter.h"
 #include "base/basic_types.h"
 
@@ -19,6 +20,14 @@ namespace style {
 namespace internal {
 namespace {
 
+// Masks are kept for the few most recently used scales of each mask.
+constexpr auto kMaxIconMaskScales = 4;
+
+struct CachedIconMask {
+	QImage image;
+	uint64 used = 0;
+};
+
 [[nodiscard]] uint32 ColorKey(QColor c) {
 	return (uint32(c.red()) << 24)
 		| (uint32(c.green()) << 16)
@@ -26,11 +35,58 @@ namespace {
 		| uint32(c.alpha());
 }
 
-base::flat_map<const IconMask*, QImage> IconMasks;
+// Negative scale keys are used for masks ignoring the device pixel ratio.
+base::flat_map<std::pair<const IconMask*, int>, CachedIconMask> IconMasks;
+uint64 IconMasksUseTick = 0;
 QMutex IconMasksMutex;
 
 base::flat_map<QPair<const IconMask*, uint32>, QPixmap> iconPixmaps;
 base::flat_set<IconData*> iconData;
+uint64 iconDataAutoincrement = 0;
+int64 iconPixmapsBytes = 0;
+rpl::lifetime iconPixmapsCache;
+bool iconPixmapsCacheRegistered = false;
+
+[[nodiscard]] int64 PixmapBytes(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * 4;
+}
+
+void ClearIconPixmaps() {
+	iconPixmaps.clear();
+	iconPixmapsBytes = 0;
+}
+
+void TrimIconPixmaps(Ui::CacheTrimLevel level) {
+	if (level == Ui::CacheTrimLevel::Critical) {
+		ResetIcons();
+		return;
+	}
+	// Drop pixmaps that are not used by any icon right now.
+	for (auto i = begin(iconPixmaps); i != end(iconPixmaps);) {
+		if (i->second.isDetached()) {
+			iconPixmapsBytes -= PixmapBytes(i->second);
+			i = iconPixmaps.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void RegisterIconPixmapsCache() {
+	if (iconPixmapsCacheRegistered) {
+		return;
+	}
+	iconPixmapsCacheRegistered = true;
+
+	// Icons hold their pixmaps, so the cache is only trimmed as a whole.
+	iconPixmapsCache = Ui::RegisterCache({
+		.name = u"icons"_q,
+		.bytes = [] { return iconPixmapsBytes; },
+		.oldestUse = [] { return uint64(); },
+		.evict = [](int64, uint64) { return int64(); },
+		.trim = TrimIconPixmaps,
+	});
+}
 
 [[nodiscard]] QImage CreateIconMask(
 		not_null<const IconMask*> mask,
@@ -110,15 +166,39 @@ base::flat_set<IconData*> iconData;
 		Qt::SmoothTransformation);
 }
 
-[[nodiscard]] QImage ResolveIconMask(not_null<const IconMask*> mask) {
+// Parsing and rendering SVG masks is expensive, so every mask is created
+// only once for each scale it is requested in.
+[[nodiscard]] QImage ResolveIconMask(
+		not_null<const IconMask*> mask,
+		int scale,
+		bool ignoreDpr = false) {
+	const auto key = std::make_pair(
+		mask.get(),
+		ignoreDpr ? -scale : scale);
 	QMutexLocker lock(&IconMasksMutex);
-	if (const auto i = IconMasks.find(mask); i != end(IconMasks)) {
-		return i->second;
+	if (const auto i = IconMasks.find(key); i != end(IconMasks)) {
+		i->second.used = ++IconMasksUseTick;
+		return i->second.image;
+	}
+
+	// Entries of one mask are adjacent, ordered by the scale key.
+	const auto from = IconMasks.lower_bound(
+		std::make_pair(mask.get(), std::numeric_limits<int>::min()));
+	auto till = from;
+	while (till != end(IconMasks) && till->first.first == mask) {
+		++till;
 	}
-	return IconMasks.emplace(
-		mask,
-		CreateIconMask(mask, Scale())
-	).first->second;
+	if (till - from >= kMaxIconMaskScales) {
+		IconMasks.erase(std::min_element(from, till, [](
+				const auto &a,
+				const auto &b) {
+			return a.second.used < b.second.used;
+		}));
+	}
+	return IconMasks.emplace(key, CachedIconMask{
+		.image = CreateIconMask(mask, scale, ignoreDpr),
+		.used = ++IconMasksUseTick,
+	}).first->second.image;
 }
 
 [[nodiscard]] QSize readGeneratedSize(
@@ -268,7 +348,7 @@ void MonoIcon::paint(
 	auto size = readGeneratedSize(_mask, Scale());
 	auto maskImage = QImage();
 	if (size.isEmpty()) {
-		maskImage = CreateIconMask(_mask, Scale());
+		maskImage = ResolveIconMask(_mask, Scale());
 		size = maskImage.size() / DevicePixelRatio();
 	}
 
@@ -299,7 +379,7 @@ void MonoIcon::fill(
 	auto size = readGeneratedSize(_mask, Scale());
 	auto maskImage = QImage();
 	if (size.isEmpty()) {
-		maskImage = CreateIconMask(_mask, Scale());
+		maskImage = ResolveIconMask(_mask, Scale());
 		size = maskImage.size() / DevicePixelRatio();
 	}
 	if (!maskImage.isNull()) {
@@ -359,7 +439,7 @@ QImage MonoIcon::instance(
 		result.fill(colorOverride);
 		return result;
 	}
-	auto mask = CreateIconMask(_mask, scale, ignoreDpr);
+	auto mask = ResolveIconMask(_mask, scale, ignoreDpr);
 	auto result = QImage(mask.size(), QImage::Format_ARGB32_Premultiplied);
 	result.setDevicePixelRatio(ratio);
 	colorizeImage(mask, colorOverride, &result);
@@ -378,7 +458,7 @@ void MonoIcon::ensureLoaded() const {
 	if (!_size.isEmpty()) {
 		_size = _size.grownBy(_padding);
 	} else {
-		_maskImage = ResolveIconMask(_mask);
+		_maskImage = ResolveIconMask(_mask, Scale());
 		createCachedPixmap();
 	}
 }
@@ -397,9 +477,11 @@ void MonoIcon::createCachedPixmap() const {
 	auto j = iconPixmaps.find(key);
 	if (j == end(iconPixmaps)) {
 		auto image = colorizeImage(_maskImage, _color);
+		RegisterIconPixmapsCache();
 		j = iconPixmaps.emplace(
 			key,
 			QPixmap::fromImage(std::move(image))).first;
+		iconPixmapsBytes += PixmapBytes(j->second);
 	}
 	_pixmap = j->second;
 	_size = (_pixmap.size() / DevicePixelRatio()).grownBy(_padding);
@@ -414,6 +496,7 @@ IconData::IconData(const IconData &other, const style::palette &palette) {
 }
 
 void IconData::created() {
+	_id = ++iconDataAutoincrement;
 	iconData.emplace(this);
 }
 
@@ -499,7 +582,7 @@ void Icon::paintInCenter(
 }
 
 void ResetIcons() {
-	iconPixmaps.clear();
+	ClearIconPixmaps();
 	for (const auto data : iconData) {
 		data->reset();
 	}
@@ -507,7 +590,9 @@ void ResetIcons() {
 
 void DestroyIcons() {
 	iconData.clear();
-	iconPixmaps.clear();
+	ClearIconPixmaps();
+	iconPixmapsCache.destroy();
+	iconPixmapsCacheRegistered = false;
 
 	QMutexLocker lock(&IconMasksMutex);
 	IconMasks.clear();
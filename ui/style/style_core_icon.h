@@ -115,6 +115,11 @@ public:
 		return _parts.empty();
 	}
 
+	// Unique for each created icon data, never reused.
+	[[nodiscard]] uint64 id() const {
+		return _id;
+	}
+
 	void paint(QPainter &p, const QPoint &pos, int outerw) const {
 		for (const auto &part : _parts) {
 			part.paint(p, pos, outerw);
@@ -169,6 +174,7 @@ private:
 	}
 
 	std::vector<MonoIcon> _parts;
+	uint64 _id = 0;
 	mutable int _width = -1;
 	mutable int _height = -1;
 
@@ -209,6 +215,11 @@ public:
 		return _data->empty();
 	}
 
+	// Same for all copies of the icon, used for keying derived images.
+	[[nodiscard]] uint64 cacheKey() const {
+		return _data->id();
+	}
+
 	int width() const {
 		return _data->width();
 	}
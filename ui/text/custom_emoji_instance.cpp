@@ -24,6 +24,8 @@ constexpr auto kMaxFrames = 180;
 constexpr auto kCacheVersion = 1;
 constexpr auto kPreloadFrames = 3;
 
+auto CachesBytes = std::atomic<int64>();
+
 struct CacheHeader {
 	int version = 0;
 	int size = 0;
@@ -162,7 +164,7 @@ void Preview::paintPath(
 	}
 }
 
-Cache::Cache(int size) : _size(size) {
+Cache::Cache(int size) : _size(size), _bytes(&CachesBytes) {
 }
 
 std::optional<Cache> Cache::FromSerialized(
@@ -211,6 +213,7 @@ std::optional<Cache> Cache::FromSerialized(
 	result._full = std::move(full);
 	result._frames = header.frames;
 	result._durations = std::move(durations);
+	result.updateBytes();
 	return result;
 }
 
@@ -291,6 +294,7 @@ void Cache::reserve(int frames) {
 		}
 	}
 	_durations.reserve(frames);
+	updateBytes();
 }
 
 int Cache::frameRowByteSize() const {
@@ -301,6 +305,14 @@ int Cache::frameByteSize() const {
 	return _size * frameRowByteSize();
 }
 
+void Cache::updateBytes() {
+	auto bytes = int64(_full.sizeInBytes());
+	for (const auto &image : _images) {
+		bytes += image.sizeInBytes();
+	}
+	_bytes.set(bytes);
+}
+
 void Cache::add(crl::time duration, const QImage &frame) {
 	Expects(!_finished);
 	Expects(frame.size() == QSize(_size, _size));
@@ -309,12 +321,15 @@ void Cache::add(crl::time duration, const QImage &frame) {
 	const auto row = (_frames / kPerRow);
 	const auto inrow = (_frames % kPerRow);
 	const auto rows = row + 1;
-	while (_images.size() < rows) {
-		_images.emplace_back();
-		_images.back() = QImage(
-			_size,
-			_size * kPerRow,
-			QImage::Format_ARGB32_Premultiplied);
+	if (_images.size() < rows) {
+		while (_images.size() < rows) {
+			_images.emplace_back();
+			_images.back() = QImage(
+				_size,
+				_size * kPerRow,
+				QImage::Format_ARGB32_Premultiplied);
+		}
+		updateBytes();
 	}
 	const auto srcPerLine = frame.bytesPerLine();
 	const auto dstPerLine = _images[row].bytesPerLine();
@@ -371,6 +386,7 @@ void Cache::finish() {
 			dst += dstPerLine;
 		}
 	}
+	updateBytes();
 }
 
 PaintFrameResult Cache::paintCurrentFrame(
@@ -434,6 +450,7 @@ Cached::Cached(
 : _unloader(std::move(unloader))
 , _cache(std::move(cache))
 , _entityData(entityData) {
+	RegisterReportedCache(u"custom emoji"_q, &CachesBytes);
 }
 
 QString Cached::entityData() const {
@@ -462,6 +479,8 @@ Renderer::Renderer(RendererDescriptor &&descriptor)
 , _loader(std::move(descriptor.loader)) {
 	Expects(_loader != nullptr);
 
+	RegisterReportedCache(u"custom emoji"_q, &CachesBytes);
+
 	const auto size = _cache.size();
 	const auto guard = base::make_weak(this);
 	crl::async([=, factory = std::move(descriptor.generator)]() mutable {
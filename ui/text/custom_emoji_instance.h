@@ -7,6 +7,7 @@
 #pragma once
 
 #include "ui/text/text_custom_emoji.h"
+#include "ui/cache_registry.h"
 #include "base/weak_ptr.h"
 #include "base/bytes.h"
 #include "base/timer.h"
@@ -104,6 +105,7 @@ private:
 	[[nodiscard]] int frameRowByteSize() const;
 	[[nodiscard]] int frameByteSize() const;
 	[[nodiscard]] crl::time currentFrameFinishes() const;
+	void updateBytes();
 
 	std::vector<QImage> _images;
 	std::vector<uint16> _durations;
@@ -113,6 +115,7 @@ private:
 	int _size = 0;
 	int _frames = 0;
 	bool _finished = false;
+	ReportedCacheBytes _bytes;
 
 };
 
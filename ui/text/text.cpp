@@ -18,6 +18,8 @@
 #include "ui/integration.h"
 #include "ui/painter.h"
 #include "base/platform/base_platform_info.h"
+#include "base/call_delayed.h"
+#include "base/unixtime.h"
 #include "styles/style_basic.h"
 
 #include <QtGui/QGuiApplication>
@@ -102,6 +104,65 @@ bool IsParagraphSeparator(QChar ch) {
 		&& (lineStartBlockHint == int(blocks.size()) - 1);
 }
 
+struct FormattedDatesUpdates {
+	std::map<std::pair<int32, uint64>, Fn<void()>> callbacks;
+	uint64 autoincrement = 0;
+	int32 scheduledFor = 0;
+};
+
+[[nodiscard]] FormattedDatesUpdates &DatesUpdates() {
+	static auto result = FormattedDatesUpdates();
+	return result;
+}
+
+void ScheduleFormattedDatesCheck();
+
+void CheckFormattedDatesUpdates() {
+	auto &updates = DatesUpdates();
+	updates.scheduledFor = 0;
+
+	const auto now = base::unixtime::now();
+	auto due = std::vector<std::pair<int32, uint64>>();
+	auto &callbacks = updates.callbacks;
+	for (const auto &[key, callback] : callbacks) {
+		if (key.first > now) {
+			break;
+		}
+		due.push_back(key);
+	}
+
+	// A callback may destroy the owners of other callbacks,
+	// so each one is looked up again right before it is called.
+	for (const auto &key : due) {
+		const auto i = callbacks.find(key);
+		if (i == end(callbacks)) {
+			continue;
+		}
+		const auto callback = std::move(i->second);
+		callbacks.erase(i);
+		callback();
+	}
+	ScheduleFormattedDatesCheck();
+}
+
+void ScheduleFormattedDatesCheck() {
+	auto &updates = DatesUpdates();
+	if (updates.callbacks.empty()) {
+		return;
+	}
+	const auto when = updates.callbacks.begin()->first.first;
+	if (updates.scheduledFor && updates.scheduledFor <= when) {
+		return;
+	}
+	updates.scheduledFor = when;
+	const auto delay = std::max(when - base::unixtime::now(), 0);
+	base::call_delayed(crl::time(delay) * 1000, [=] {
+		if (DatesUpdates().scheduledFor == when) {
+			CheckFormattedDatesUpdates();
+		}
+	});
+}
+
 } // namespace
 } // namespace Ui::Text
 
@@ -1964,7 +2025,150 @@ const std::vector<Modification> &String::modifications() const {
 }
 
 int32 String::nextFormattedDateUpdate() const {
-	return _extended ? _extended->nextFormattedDateUpdate : 0;
+	const auto dates = _extended ? _extended->formattedDates.get() : nullptr;
+	return dates ? dates->nextUpdate : 0;
+}
+
+bool String::updateFormattedDates(int32 now) {
+	const auto dates = _extended ? _extended->formattedDates.get() : nullptr;
+	if (!dates || !dates->nextUpdate || dates->nextUpdate > now) {
+		return false;
+	}
+	const auto byPosition = [](const Word &word) { return word.position(); };
+
+	// Dates of one paragraph are replaced together and then only the words
+	// of this paragraph are parsed again, the blocks are only shifted.
+	struct Paragraph {
+		int from = 0;
+		int till = 0;
+		int delta = 0;
+	};
+	auto paragraphs = std::vector<Paragraph>();
+	auto paragraphFrom = -1;
+	auto paragraphTill = 0;
+	auto paragraphDelta = 0;
+	const auto startParagraph = [&](int position) {
+		const auto newline = position
+			? _text.lastIndexOf(QChar::LineFeed, position - 1)
+			: -1;
+		paragraphFrom = std::max(int(newline), 0);
+		paragraphTill = _text.indexOf(QChar::LineFeed, position);
+		if (paragraphTill < 0) {
+			paragraphTill = _text.size();
+		}
+		if (hasSkipBlock()) {
+			accumulate_min(paragraphTill, int(_blocks.back()->position()));
+		}
+		paragraphDelta = 0;
+	};
+	const auto finishParagraph = [&] {
+		if (paragraphFrom >= 0) {
+			paragraphs.push_back({
+				.from = paragraphFrom,
+				.till = paragraphTill,
+				.delta = paragraphDelta,
+			});
+			paragraphFrom = -1;
+		}
+	};
+	const auto parseParagraph = [&](const Paragraph &paragraph) {
+		// Words after this paragraph are not shifted by its delta yet.
+		const auto wordsFrom = ranges::lower_bound(
+			_words,
+			uint16(paragraph.from),
+			ranges::less(),
+			byPosition) - begin(_words);
+		const auto wordsTill = ranges::lower_bound(
+			_words,
+			uint16(paragraph.till - paragraph.delta),
+			ranges::less(),
+			byPosition) - begin(_words);
+		auto words = std::vector<Word>();
+		WordParser parser(this, paragraph.from, paragraph.till, words);
+		_words.erase(begin(_words) + wordsFrom, begin(_words) + wordsTill);
+		_words.insert(begin(_words) + wordsFrom, begin(words), end(words));
+		if (paragraph.delta) {
+			const auto after = wordsFrom + int(words.size());
+			for (auto i = begin(_words) + after; i != end(_words); ++i) {
+				i->setPosition(i->position() + paragraph.delta);
+			}
+		}
+	};
+
+	const auto limit = int(std::numeric_limits<uint16>::max());
+	auto changed = false;
+	dates->nextUpdate = 0;
+	for (auto &date : dates->list) {
+		if (date.nextUpdate && date.nextUpdate <= now) {
+			const auto result = dates->factory(date.date, date.flags);
+			const auto &text = result.text;
+			date.nextUpdate = result.nextUpdate;
+
+			// Empty dates don't have blocks of their own to be updated.
+			const auto replace = date.length
+				&& !text.isEmpty()
+				&& (_text.size() - date.length + text.size() < limit)
+				&& (QStringView(_text).mid(date.position, date.length)
+					!= text);
+			if (replace) {
+				if (paragraphFrom >= 0 && date.position >= paragraphTill) {
+					finishParagraph();
+				}
+				if (paragraphFrom < 0) {
+					startParagraph(date.position);
+				}
+				const auto delta = replaceFormattedDate(date, text);
+				paragraphTill += delta;
+				paragraphDelta += delta;
+				changed = true;
+			}
+		}
+		if (date.nextUpdate
+			&& (!dates->nextUpdate || date.nextUpdate < dates->nextUpdate)) {
+			dates->nextUpdate = date.nextUpdate;
+		}
+	}
+	finishParagraph();
+	if (changed) {
+		// Words are measured using the simple paragraph flags,
+		// so those are computed for the new text before parsing.
+		BlockParser::ComputeSimpleParagraphs(this);
+		for (const auto &paragraph : paragraphs) {
+			parseParagraph(paragraph);
+		}
+		recountNaturalSize(false);
+	}
+	return changed;
+}
+
+int String::replaceFormattedDate(
+		FormattedDateSpan &date,
+		const QString &text) {
+	const auto position = int(date.position);
+	const auto delta = int(text.size()) - int(date.length);
+	_text.replace(position, date.length, text);
+	date.length = uint16(text.size());
+	if (!delta) {
+		return 0;
+	}
+	for (auto &block : _blocks) {
+		if (block->position() > position) {
+			block->setPosition(block->position() + delta);
+		}
+	}
+	for (auto &modification : _extended->modifications) {
+		if (modification.position > position) {
+			modification.position += delta;
+		} else if (modification.position == position) {
+			modification.added = uint16(modification.added + delta);
+		}
+	}
+	for (auto &other : _extended->formattedDates->list) {
+		if (other.position > position) {
+			other.position += delta;
+		}
+	}
+	return delta;
 }
 
 QString String::toString(TextSelection selection) const {
@@ -2224,6 +2428,8 @@ void String::clear() {
 	_startQuoteIndex = 0;
 	_startParagraphLTR = false;
 	_startParagraphRTL = false;
+	_startParagraphSimple = false;
+	_singleScriptLTR = false;
 	_hasCustomEmoji = false;
 	_isIsolatedEmoji = false;
 	_isOnlyCustomEmoji = false;
@@ -2374,4 +2580,19 @@ QSize CountOptimalTextSize(
 	}), height };
 }
 
+rpl::lifetime ScheduleFormattedDatesUpdate(
+		int32 when,
+		Fn<void()> callback) {
+	Expects(when > 0);
+	Expects(callback != nullptr);
+
+	auto &updates = DatesUpdates();
+	const auto key = std::make_pair(when, ++updates.autoincrement);
+	updates.callbacks.emplace(key, std::move(callback));
+	ScheduleFormattedDatesCheck();
+	return rpl::lifetime([=] {
+		DatesUpdates().callbacks.erase(key);
+	});
+}
+
 } // namespace Ui::Text
@@ -12,6 +12,7 @@
 #include "ui/style/style_core_types.h"
 
 #include <crl/crl_time.h>
+#include <rpl/lifetime.h>
 
 #include <any>
 
@@ -86,6 +87,7 @@ struct OnlyCustomEmoji;
 struct SpoilerData;
 struct QuoteDetails;
 struct QuotesData;
+struct FormattedDateSpan;
 struct ExtendedData;
 struct MarkedContext;
 
@@ -429,6 +431,11 @@ public:
 	[[nodiscard]] const std::vector<Modification> &modifications() const;
 	[[nodiscard]] int32 nextFormattedDateUpdate() const;
 
+	// Re-evaluates formatted dates due by 'now' without parsing the text
+	// again, only paragraphs with changed dates are measured again.
+	// Returns true if the text was changed, the size may change as well.
+	bool updateFormattedDates(int32 now);
+
 	[[nodiscard]] const style::TextStyle *style() const {
 		return _st;
 	}
@@ -527,6 +534,9 @@ private:
 		GeometryDescriptor geometry,
 		Callback &&callback) const;
 
+	[[nodiscard]] int replaceFormattedDate(
+		FormattedDateSpan &date,
+		const QString &text);
 	void insertModifications(int position, int delta);
 	void insertReplacement(int position, int skipped, int added);
 	void removeModificationsAfter(int size);
@@ -551,6 +561,8 @@ private:
 	uint16 _startQuoteIndex = 0;
 	bool _startParagraphLTR : 1 = false;
 	bool _startParagraphRTL : 1 = false;
+	bool _startParagraphSimple : 1 = false;
+	bool _singleScriptLTR : 1 = false;
 	bool _hasCustomEmoji : 1 = false;
 	bool _isIsolatedEmoji : 1 = false;
 	bool _isOnlyCustomEmoji : 1 = false;
@@ -582,6 +594,13 @@ private:
 	int minWidth,
 	int maxWidth);
 
+// Calls 'callback' when the unixtime 'when' comes, so that the owner can
+// call String::updateFormattedDates(). All the callbacks due at the same
+// moment are called together from a single timer shot.
+[[nodiscard]] rpl::lifetime ScheduleFormattedDatesUpdate(
+	int32 when,
+	Fn<void()> callback);
+
 } // namespace Ui::Text
 
 inline TextSelection snapSelection(int from, int to) {
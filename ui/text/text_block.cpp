@@ -71,6 +71,10 @@ uint16 AbstractBlock::position() const {
 	return _position;
 }
 
+void AbstractBlock::setPosition(uint16 position) {
+	_position = position;
+}
+
 TextBlockType AbstractBlock::type() const {
 	return static_cast<TextBlockType>(_type);
 }
@@ -67,6 +67,7 @@ struct BlockDescriptor {
 class AbstractBlock {
 public:
 	[[nodiscard]] uint16 position() const;
+	void setPosition(uint16 position);
 	[[nodiscard]] TextBlockType type() const;
 	[[nodiscard]] TextBlockFlags flags() const;
 	[[nodiscard]] int objectWidth() const;
@@ -108,10 +109,20 @@ public:
 		return UnpackParagraphDirection(_paragraphLTR, _paragraphRTL);
 	}
 
+	// Paragraph has no characters that may start bidi reordering
+	// and at most one script apart from Common and Inherited.
+	void setParagraphSimple(bool simple) {
+		_paragraphSimple = simple;
+	}
+	[[nodiscard]] bool paragraphSimple() const {
+		return _paragraphSimple;
+	}
+
 private:
 	uint16 _quoteIndex = 0;
 	bool _paragraphLTR : 1 = false;
 	bool _paragraphRTL : 1 = false;
+	bool _paragraphSimple : 1 = false;
 
 };
 
@@ -78,6 +78,39 @@ constexpr auto kMaxDiacAfterSymbol = 2;
 		&& (category != QChar::Other_NotAssigned);
 }
 
+[[nodiscard]] bool MayStartBidi(char32_t ucs4) {
+	if (ucs4 < 0x590) {
+		return false;
+	}
+	// Same list as in BidiAlgorithm::checkForBidi.
+	switch (QChar::direction(ucs4)) {
+	case QChar::DirR:
+	case QChar::DirAN:
+	case QChar::DirLRE:
+	case QChar::DirLRO:
+	case QChar::DirAL:
+	case QChar::DirRLE:
+	case QChar::DirRLO:
+	case QChar::DirPDF:
+	case QChar::DirLRI:
+	case QChar::DirRLI:
+	case QChar::DirFSI:
+	case QChar::DirPDI:
+		return true;
+	default:
+		return false;
+	}
+}
+
+[[nodiscard]] QChar::Script ScriptOf(char32_t ucs4) {
+	if (ucs4 < 0x80) {
+		return ((ucs4 >= 'a' && ucs4 <= 'z') || (ucs4 >= 'A' && ucs4 <= 'Z'))
+			? QChar::Script_Latin
+			: QChar::Script_Common;
+	}
+	return QChar::script(ucs4);
+}
+
 } // namespace
 
 BlockParser::StartedEntity::StartedEntity(TextBlockFlags flags)
@@ -403,15 +436,27 @@ bool BlockParser::checkEntities() {
 			const auto result = _context.formattedDateFactory(
 				dateValue,
 				dateFlags);
+			const auto position = int(_tText.size());
+			const auto &formatted = result.text;
 			if (result.nextUpdate) {
-				auto &next = _t->ensureExtended()->nextFormattedDateUpdate;
-				if (!next || result.nextUpdate < next) {
-					next = result.nextUpdate;
+				auto &dates = _t->ensureExtended()->formattedDates;
+				if (!dates) {
+					dates = std::make_unique<FormattedDatesData>();
+					dates->factory = _context.formattedDateFactory;
+				}
+				dates->list.push_back({
+					.date = dateValue,
+					.flags = dateFlags,
+					.nextUpdate = result.nextUpdate,
+					.position = uint16(position),
+					.length = uint16(formatted.size()),
+				});
+				if (!dates->nextUpdate
+					|| result.nextUpdate < dates->nextUpdate) {
+					dates->nextUpdate = result.nextUpdate;
 				}
 			}
 
-			const auto position = int(_tText.size());
-			const auto &formatted = result.text;
 			_t->insertReplacement(
 				position,
 				entityLength,
@@ -910,6 +955,7 @@ void BlockParser::finalize(const TextParseOptions &options) {
 		_t->_isIsolatedEmoji = false;
 	}
 	finishSpacesCheck(length);
+	ComputeSimpleParagraphs(_t);
 	_tText.squeeze();
 	_tBlocks.shrink_to_fit();
 	if (const auto extended = _t->_extended.get()) {
@@ -918,6 +964,64 @@ void BlockParser::finalize(const TextParseOptions &options) {
 	}
 }
 
+void BlockParser::ComputeSimpleParagraphs(not_null<String*> string) {
+	const auto chars = string->_text.constData();
+	const auto length = int(string->_text.size());
+	auto paragraph = (NewlineBlock*)nullptr;
+	auto paragraphScript = QChar::Script_Common;
+	auto paragraphSimple = true;
+	auto textScript = QChar::Script_Common;
+	auto textSimple = true;
+	const auto finishParagraph = [&] {
+		if (paragraph) {
+			paragraph->setParagraphSimple(paragraphSimple);
+		} else {
+			string->_startParagraphSimple = paragraphSimple;
+		}
+		textSimple = textSimple && paragraphSimple;
+		paragraphScript = QChar::Script_Common;
+		paragraphSimple = true;
+	};
+	const auto checkScript = [](QChar::Script &was, QChar::Script now) {
+		if (now <= QChar::Script_Common || now == was) {
+			return true;
+		} else if (was <= QChar::Script_Common) {
+			was = now;
+			return true;
+		}
+		return false;
+	};
+	auto block = begin(string->_blocks);
+	const auto blocksEnd = end(string->_blocks);
+	for (auto i = 0; i != length; ++i) {
+		while (block != blocksEnd && (*block)->position() <= i) {
+			if ((*block)->type() == TextBlockType::Newline) {
+				finishParagraph();
+				paragraph = &block->unsafe<NewlineBlock>();
+			}
+			++block;
+		}
+		if (!paragraphSimple) {
+			continue;
+		}
+		auto ucs4 = char32_t(chars[i].unicode());
+		if (chars[i].isHighSurrogate()
+			&& i + 1 != length
+			&& chars[i + 1].isLowSurrogate()) {
+			ucs4 = QChar::surrogateToUcs4(chars[i], chars[i + 1]);
+			++i;
+		}
+		const auto script = ScriptOf(ucs4);
+		if (MayStartBidi(ucs4) || !checkScript(paragraphScript, script)) {
+			paragraphSimple = false;
+		} else if (textSimple && !checkScript(textScript, script)) {
+			textSimple = false;
+		}
+	}
+	finishParagraph();
+	string->_singleScriptLTR = textSimple;
+}
+
 void BlockParser::computeLinkText(
 		const QString &linkData,
 		QString *outLinkText,
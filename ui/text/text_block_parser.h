@@ -21,6 +21,9 @@ public:
 		const TextParseOptions &options,
 		const MarkedContext &context);
 
+	// Also used after formatted dates are replaced in place.
+	static void ComputeSimpleParagraphs(not_null<String*> string);
+
 private:
 	struct ReadyToken {
 	};
@@ -1290,6 +1290,394 @@ bool IsSentenceEnd(QChar ch) {
 		|| (ch == '!');
 }
 
+// Same characters as in RegExpWordSplit().
+[[nodiscard]] inline bool IsWordSplitter(QChar ch) {
+	switch (ch.unicode()) {
+	case 0: case '\t': case '\n': case '\v': case '\f': case '\r': case ' ':
+	case '@': case '-': case '+': case '(': case ')': case '[': case ']':
+	case '{': case '}': case '<': case '>': case ',': case '.': case ':':
+	case '!': case '_': case ';': case '"': case '\'':
+		return true;
+	}
+	return false;
+}
+
+enum class FoldMode : uchar {
+	Accents, // RemoveAccents(text)
+	AccentsLower, // RemoveAccents(text).toLower()
+	LowerAccents, // RemoveAccents(text.toLower())
+};
+constexpr auto kFoldModesCount = 3;
+
+// Two level table: 256 pages of 256 code units each. Pages that map
+// all the characters to themselves are not stored. Zero entries are
+// resolved by the slow path: removed diacritics, surrogates and
+// characters lowercased into several code units.
+struct FoldTable {
+	std::array<uint8, 256> pages = { { 0 } };
+	std::vector<std::array<char16_t, 256>> data;
+
+	[[nodiscard]] char16_t map(char16_t code) const {
+		const auto page = pages[code >> 8];
+		return page ? data[page - 1][code & 0xFF] : code;
+	}
+};
+
+// Returns -1 if the character is removed.
+[[nodiscard]] int FoldAccent(char16_t code) {
+	if (code < 128) {
+		return code;
+	}
+	const auto ch = QChar(code);
+	if (IsDiacritic(ch)) {
+		return -1;
+	}
+	const auto noAccent = RemoveOneAccent(code);
+	return (noAccent.unicode() > 0 && noAccent != ch)
+		? noAccent.unicode()
+		: code;
+}
+
+// Returns -1 if the lowercase variant has several code units.
+[[nodiscard]] int LowerSingle(char16_t code) {
+	const auto lower = QString(QChar(code)).toLower();
+	return (lower.size() == 1) ? lower[0].unicode() : -1;
+}
+
+[[nodiscard]] std::array<FoldTable, kFoldModesCount> BuildFoldTables() {
+	auto result = std::array<FoldTable, kFoldModesCount>();
+	auto lowered = std::array<int, 256>();
+	auto page = std::array<char16_t, 256>();
+	for (auto index = 0; index != 256; ++index) {
+		const auto first = char16_t(index << 8);
+		const auto surrogates = QChar::isSurrogate(first);
+		if (!surrogates) {
+			auto units = QString(256, QChar());
+			for (auto i = 0; i != 256; ++i) {
+				units[i] = QChar(char16_t(first + i));
+			}
+			const auto lower = units.toLower();
+			for (auto i = 0; i != 256; ++i) {
+				lowered[i] = (lower.size() == 256)
+					? lower[i].unicode()
+					: LowerSingle(char16_t(first + i));
+			}
+		}
+		for (auto mode = 0; mode != kFoldModesCount; ++mode) {
+			auto identity = true;
+			for (auto i = 0; i != 256; ++i) {
+				const auto code = char16_t(first + i);
+				const auto entry = [&]() -> int {
+					switch (FoldMode(mode)) {
+					case FoldMode::Accents:
+						return FoldAccent(code);
+					case FoldMode::AccentsLower: {
+						const auto folded = surrogates ? -1 : FoldAccent(code);
+						return (folded < 0)
+							? -1
+							: (folded == code)
+							? lowered[i]
+							: LowerSingle(char16_t(folded));
+					}
+					case FoldMode::LowerAccents:
+						return (surrogates || lowered[i] < 0)
+							? -1
+							: FoldAccent(char16_t(lowered[i]));
+					}
+					Unexpected("Mode in BuildFoldTables.");
+				}();
+				page[i] = (entry > 0) ? char16_t(entry) : char16_t(0);
+				if (page[i] != code) {
+					identity = false;
+				}
+			}
+			if (!identity) {
+				auto &table = result[mode];
+				Assert(table.data.size() < 255);
+				table.data.push_back(page);
+				table.pages[index] = uint8(table.data.size());
+			}
+		}
+	}
+	return result;
+}
+
+[[nodiscard]] const FoldTable &FoldTableFor(FoldMode mode) {
+	static const auto Tables = BuildFoldTables();
+	return Tables[int(mode)];
+}
+
+// Appends the normalized 'text' to the 'buffer' in a single pass.
+// If 'words' are provided the text is split like in PrepareSearchWords,
+// splitter characters are not appended and word ranges are collected.
+void Normalize(
+		QStringView text,
+		QString &buffer,
+		FoldMode mode,
+		bool stripEmoji,
+		std::vector<std::pair<int, int>> *words = nullptr) {
+	Expects(!words || mode == FoldMode::LowerAccents);
+
+	const auto &table = FoldTableFor(mode);
+	const auto start = int(buffer.size());
+	auto wordStart = start;
+	const auto finishWord = [&] {
+		auto from = wordStart;
+		auto till = int(buffer.size());
+		while (from < till && buffer.at(from).isSpace()) {
+			++from;
+		}
+		while (till > from && buffer.at(till - 1).isSpace()) {
+			--till;
+		}
+		if (till > from) {
+			words->emplace_back(from, till - from);
+		}
+		wordStart = int(buffer.size());
+	};
+	const auto append = [&](QChar ch) {
+		if (words && IsWordSplitter(ch)) {
+			finishWord();
+		} else {
+			buffer.append(ch);
+		}
+	};
+	const auto appendFolded = [&](char16_t code) {
+		const auto folded = FoldAccent(code);
+		if (folded >= 0) {
+			append(QChar(char16_t(folded)));
+		}
+	};
+
+	buffer.reserve(buffer.size() + text.size());
+	const auto end = text.end();
+	for (auto ch = text.begin(); ch != end; ++ch) {
+		if (stripEmoji) {
+			auto length = 0;
+			if (Ui::Emoji::Find(ch, end, &length)) {
+				ch += length - 1;
+				continue;
+			}
+		}
+		const auto code = ch->unicode();
+		if (const auto mapped = table.map(code)) {
+			append(QChar(mapped));
+			continue;
+		}
+		switch (mode) {
+		case FoldMode::Accents:
+			appendFolded(code);
+			break;
+		case FoldMode::AccentsLower: {
+			const auto folded = FoldAccent(code);
+			if (folded < 0) {
+				break;
+			}
+			const auto unit = QChar(char16_t(folded));
+			if (unit.isLowSurrogate()
+				&& buffer.size() > start
+				&& buffer.back().isHighSurrogate()) {
+				// Diacritics between surrogates are removed before
+				// lowercasing, so the pair is assembled in the buffer.
+				const auto lower = QChar::toLower(QChar::surrogateToUcs4(
+					buffer.back(),
+					unit));
+				buffer.back() = QChar(QChar::highSurrogate(lower));
+				append(QChar(QChar::lowSurrogate(lower)));
+			} else if (unit.isSurrogate()) {
+				append(unit);
+			} else {
+				for (const auto lower : QString(unit).toLower()) {
+					append(lower);
+				}
+			}
+		} break;
+		case FoldMode::LowerAccents:
+			if (ch->isHighSurrogate()
+				&& (ch + 1) != end
+				&& (ch + 1)->isLowSurrogate()) {
+				const auto lower = QChar::toLower(QChar::surrogateToUcs4(
+					*ch,
+					*(ch + 1)));
+				append(QChar(QChar::highSurrogate(lower)));
+				append(QChar(QChar::lowSurrogate(lower)));
+				++ch;
+			} else if (ch->isSurrogate()) {
+				append(*ch);
+			} else {
+				for (const auto lower : QString(*ch).toLower()) {
+					appendFolded(lower.unicode());
+				}
+			}
+			break;
+		}
+	}
+	if (words) {
+		finishWord();
+	}
+}
+
+struct TextCut {
+	int position = 0;
+	int entity = 0;
+	bool inEntity = false;
+	bool canBreakEntity = false;
+};
+
+// Finds the best place to cut the text part starting at 'from', if it
+// doesn't fit in 'limit' characters. Entities before 'firstEntity' are
+// already sent, others are treated as cut at 'from', like shiftLeft does.
+[[nodiscard]] std::optional<TextCut> FindTextCut(
+		const TextWithEntities &text,
+		int from,
+		int firstEntity,
+		int limit) {
+	const auto &entities = text.entities;
+	const auto entityCount = int(entities.size());
+	const auto entityOffset = [&](int index) {
+		return std::max(entities[index].offset(), from);
+	};
+	const auto entityEnd = [&](int index) {
+		const auto &entity = entities[index];
+		return std::max(entity.offset() + entity.length(), from);
+	};
+	const auto breaksAround = [&](int index) {
+		const auto type = entities[index].type();
+		return (type == EntityType::Pre) || (type == EntityType::Blockquote);
+	};
+
+	auto result = TextCut{ .position = from, .entity = firstEntity };
+	auto currentEntity = firstEntity;
+	auto goodLevel = 0;
+	const auto half = limit / 2;
+	const auto start = text.text.constData();
+	const auto end = start + text.text.size();
+	auto s = 0;
+	for (auto ch = start + from; ch != end; ++ch, ++s) {
+		const auto position = int(ch - start);
+		while (currentEntity < entityCount
+			&& position >= entityEnd(currentEntity)) {
+			++currentEntity;
+		}
+
+		if (s > half) {
+			const auto inEntity = (currentEntity < entityCount)
+				&& (position > entityOffset(currentEntity))
+				&& (position < entityEnd(currentEntity));
+			const auto entityType = (currentEntity < entityCount)
+				? entities[currentEntity].type()
+				: EntityType::Invalid;
+			const auto canBreakEntity = (entityType == EntityType::Pre)
+				|| (entityType == EntityType::Blockquote)
+				|| (entityType == EntityType::Code); // #TODO entities
+			const auto noEntityLevel = inEntity ? 0 : 1;
+
+			const auto markGoodAsLevel = [&](int newLevel) {
+				if (goodLevel > newLevel) {
+					return;
+				}
+				goodLevel = newLevel;
+				result = TextCut{
+					.position = position,
+					.entity = currentEntity,
+					.inEntity = inEntity,
+					.canBreakEntity = canBreakEntity,
+				};
+			};
+
+			if (inEntity && !canBreakEntity) {
+				markGoodAsLevel(0);
+			} else if (IsNewline(*ch)) {
+				if (inEntity) {
+					if (ch + 1 < end && IsNewline(*(ch + 1))) {
+						markGoodAsLevel(12);
+					} else {
+						markGoodAsLevel(11);
+					}
+				} else if (ch + 1 < end && IsNewline(*(ch + 1))) {
+					markGoodAsLevel(15);
+				} else if (currentEntity < entityCount
+					&& position + 1 == entityOffset(currentEntity)
+					&& breaksAround(currentEntity)) {
+					markGoodAsLevel(14);
+				} else if (currentEntity > firstEntity
+					&& position == entityEnd(currentEntity - 1)
+					&& breaksAround(currentEntity - 1)) {
+					markGoodAsLevel(14);
+				} else {
+					markGoodAsLevel(13);
+				}
+			} else if (IsSpace(*ch)) {
+				if (IsSentenceEnd(*(ch - 1))) {
+					markGoodAsLevel(9 + noEntityLevel);
+				} else if (IsSentencePartEnd(*(ch - 1))) {
+					markGoodAsLevel(7 + noEntityLevel);
+				} else {
+					markGoodAsLevel(5 + noEntityLevel);
+				}
+			} else if (IsWordSeparator(*(ch - 1))) {
+				markGoodAsLevel(3 + noEntityLevel);
+			} else {
+				markGoodAsLevel(1 + noEntityLevel);
+			}
+		}
+
+		auto elen = 0;
+		if (Ui::Emoji::Find(ch, end, &elen)) {
+			for (auto i = 0; i < elen; ++i, ++ch, ++s) {
+				if (ch->isHighSurrogate()
+					&& i + 1 < elen
+					&& (ch + 1)->isLowSurrogate()) {
+					++ch;
+					++i;
+				}
+			}
+			--ch;
+			--s;
+		} else if (ch->isHighSurrogate()
+			&& ch + 1 < end
+			&& (ch + 1)->isLowSurrogate()) {
+			++ch;
+		}
+		if (s >= limit) {
+			return result;
+		}
+	}
+	return std::nullopt;
+}
+
+// Cuts at 'from' + 'limit' no matter what, used when FindTextCut() can't
+// find a place that makes progress. Entities crossing the cut are clipped.
+[[nodiscard]] TextCut HardTextCut(
+		const TextWithEntities &text,
+		int from,
+		int firstEntity,
+		int limit) {
+	const auto &entities = text.entities;
+	const auto entityCount = int(entities.size());
+	auto result = TextCut{
+		.position = std::min(from + limit, int(text.text.size())),
+		.entity = firstEntity,
+	};
+	if (result.position > from + 1
+		&& result.position < text.text.size()
+		&& text.text[result.position - 1].isHighSurrogate()) {
+		--result.position;
+	}
+	while (result.entity < entityCount) {
+		const auto &entity = entities[result.entity];
+		if (entity.offset() + entity.length() > result.position) {
+			break;
+		}
+		++result.entity;
+	}
+	if (result.entity < entityCount
+		&& entities[result.entity].offset() < result.position) {
+		result.inEntity = result.canBreakEntity = true;
+	}
+	return result;
+}
+
 } // namespace
 
 const QRegularExpression &RegExpMailNameAtEnd() {
@@ -1437,39 +1825,9 @@ TextWithEntities SingleLine(const TextWithEntities &text) {
 }
 
 QString RemoveAccents(const QString &text) {
-	auto result = text;
-	auto copying = false;
-	auto i = 0;
-	for (auto s = text.unicode(), ch = s, e = text.unicode() + text.size(); ch != e; ++ch, ++i) {
-		if (ch->unicode() < 128) {
-			if (copying) result[i] = *ch;
-			continue;
-		}
-		if (IsDiacritic(*ch)) {
-			copying = true;
-			--i;
-			continue;
-		}
-		if (ch->isHighSurrogate() && ch + 1 < e && (ch + 1)->isLowSurrogate()) {
-			auto noAccent = RemoveOneAccent(QChar::surrogateToUcs4(*ch, *(ch + 1)));
-			if (noAccent.unicode() > 0) {
-				copying = true;
-				result[i] = noAccent;
-			} else {
-				if (copying) result[i] = *ch;
-				++ch, ++i;
-				if (copying) result[i] = *ch;
-			}
-		} else {
-			auto noAccent = RemoveOneAccent(ch->unicode());
-			if (noAccent.unicode() > 0 && noAccent != *ch) {
-				result[i] = noAccent;
-			} else if (copying) {
-				result[i] = *ch;
-			}
-		}
-	}
-	return (i < result.size()) ? result.mid(0, i) : result;
+	auto result = QString();
+	Normalize(text, result, FoldMode::Accents, false);
+	return result;
 }
 
 QString RemoveEmoji(const QString &text) {
@@ -1479,6 +1837,11 @@ QString RemoveEmoji(const QString &text) {
 	auto begin = text.data();
 	const auto end = begin + text.size();
 	while (begin != end) {
+		const auto next = Ui::Emoji::SkipToPossibleEmoji(begin, end);
+		result.append(begin, next - begin);
+		if ((begin = next) == end) {
+			break;
+		}
 		auto length = 0;
 		if (Ui::Emoji::Find(begin, end, &length)) {
 			begin += length;
@@ -1490,19 +1853,32 @@ QString RemoveEmoji(const QString &text) {
 }
 
 QString NameSortKey(const QString &text) {
-	return RemoveAccents(text).toLower();
+	auto result = QString();
+	Normalize(text, result, FoldMode::AccentsLower, false);
+	return result;
+}
+
+void AppendNameSortKey(QStringView text, QString &buffer, bool stripEmoji) {
+	Normalize(text, buffer, FoldMode::AccentsLower, stripEmoji);
 }
 
 QStringList PrepareSearchWords(
 		const QString &query,
 		const QRegularExpression *SplitterOverride) {
-	auto clean = RemoveAccents(query.trimmed().toLower());
 	auto result = QStringList();
+	if (!SplitterOverride) {
+		auto buffer = QString();
+		auto words = std::vector<QStringView>();
+		PrepareSearchWords(query, buffer, words);
+		result.reserve(words.size());
+		for (const auto &word : words) {
+			result.push_back(word.toString());
+		}
+		return result;
+	}
+	auto clean = RemoveAccents(query.trimmed().toLower());
 	if (!clean.isEmpty()) {
-		auto list = clean.split(SplitterOverride
-			? *SplitterOverride
-			: RegExpWordSplit(),
-			Qt::SkipEmptyParts);
+		auto list = clean.split(*SplitterOverride, Qt::SkipEmptyParts);
 		result.reserve(list.size());
 		for (const auto &word : std::as_const(list)) {
 			auto trimmed = word.trimmed();
@@ -1514,122 +1890,108 @@ QStringList PrepareSearchWords(
 	return result;
 }
 
+void PrepareSearchWords(
+		QStringView query,
+		QString &buffer,
+		std::vector<QStringView> &words,
+		bool stripEmoji) {
+	auto ranges = std::vector<std::pair<int, int>>();
+	buffer.clear();
+	words.clear();
+	Normalize(query, buffer, FoldMode::LowerAccents, stripEmoji, &ranges);
+	words.reserve(ranges.size());
+	for (const auto &[from, length] : ranges) {
+		words.push_back(QStringView(buffer).mid(from, length));
+	}
+}
+
 bool CutPart(TextWithEntities &sending, TextWithEntities &left, int32 limit) {
 	Expects(limit > 0);
 
 	if (left.text.isEmpty()) {
 		return false;
 	}
+	const auto cut = FindTextCut(left, 0, 0, limit);
+	if (!cut) {
+		sending = base::take(left);
+		return true;
+	}
+	const auto good = cut->position;
+	sending.text = left.text.mid(0, good);
+	left.text = left.text.mid(good);
+	if (cut->inEntity && cut->canBreakEntity) {
+		sending.entities = left.entities.mid(0, cut->entity + 1);
+		sending.entities.back().updateTextEnd(good);
+		left.entities = left.entities.mid(cut->entity);
+	} else {
+		sending.entities = left.entities.mid(0, cut->entity);
+		left.entities = left.entities.mid(cut->inEntity
+			? (cut->entity + 1)
+			: cut->entity);
+	}
+	for (auto &entity : left.entities) {
+		entity.shiftLeft(good);
+	}
+	return true;
+}
 
-	int32 currentEntity = 0, goodEntity = currentEntity, entityCount = left.entities.size();
-	bool goodInEntity = false, goodCanBreakEntity = false;
+std::vector<TextPartRange> SplitIntoParts(
+		const TextWithEntities &text,
+		int limit) {
+	Expects(limit > 0);
 
-	int32 s = 0, half = limit / 2, goodLevel = 0;
-	for (const QChar *start = left.text.constData(), *ch = start, *end = left.text.constEnd(), *good = ch; ch != end; ++ch, ++s) {
-		while (currentEntity < entityCount && ch >= start + left.entities[currentEntity].offset() + left.entities[currentEntity].length()) {
-			++currentEntity;
+	auto result = std::vector<TextPartRange>();
+	const auto size = int(text.text.size());
+	auto from = 0;
+	auto firstEntity = 0;
+	while (from < size) {
+		auto cut = FindTextCut(text, from, firstEntity, limit);
+		if (cut && cut->position <= from) {
+			// No good place to cut, like a long unbreakable emoji run.
+			cut = HardTextCut(text, from, firstEntity, limit);
 		}
-
-		if (s > half) {
-			bool inEntity = (currentEntity < entityCount) && (ch > start + left.entities[currentEntity].offset()) && (ch < start + left.entities[currentEntity].offset() + left.entities[currentEntity].length());
-			EntityType entityType = (currentEntity < entityCount) ? left.entities[currentEntity].type() : EntityType::Invalid;
-			bool canBreakEntity = (entityType == EntityType::Pre)
-				|| (entityType == EntityType::Blockquote)
-				|| (entityType == EntityType::Code); // #TODO entities
-			int32 noEntityLevel = inEntity ? 0 : 1;
-
-			auto markGoodAsLevel = [&](int newLevel) {
-				if (goodLevel > newLevel) {
-					return;
-				}
-				goodLevel = newLevel;
-				good = ch;
-				goodEntity = currentEntity;
-				goodInEntity = inEntity;
-				goodCanBreakEntity = canBreakEntity;
-			};
-
-			if (inEntity && !canBreakEntity) {
-				markGoodAsLevel(0);
-			} else {
-				if (IsNewline(*ch)) {
-					if (inEntity) {
-						if (ch + 1 < end && IsNewline(*(ch + 1))) {
-							markGoodAsLevel(12);
-						} else {
-							markGoodAsLevel(11);
-						}
-					} else if (ch + 1 < end && IsNewline(*(ch + 1))) {
-						markGoodAsLevel(15);
-					} else if (currentEntity < entityCount
-						&& ch + 1 == start + left.entities[currentEntity].offset()
-						&& (left.entities[currentEntity].type() == EntityType::Pre
-							|| left.entities[currentEntity].type() == EntityType::Blockquote)) {
-						markGoodAsLevel(14);
-					} else if (currentEntity > 0
-						&& ch == start + left.entities[currentEntity - 1].offset() + left.entities[currentEntity - 1].length()
-						&& (left.entities[currentEntity - 1].type() == EntityType::Pre
-							|| left.entities[currentEntity - 1].type() == EntityType::Blockquote)) {
-						markGoodAsLevel(14);
-					} else {
-						markGoodAsLevel(13);
-					}
-				} else if (IsSpace(*ch)) {
-					if (IsSentenceEnd(*(ch - 1))) {
-						markGoodAsLevel(9 + noEntityLevel);
-					} else if (IsSentencePartEnd(*(ch - 1))) {
-						markGoodAsLevel(7 + noEntityLevel);
-					} else {
-						markGoodAsLevel(5 + noEntityLevel);
-					}
-				} else if (IsWordSeparator(*(ch - 1))) {
-					markGoodAsLevel(3 + noEntityLevel);
-				} else {
-					markGoodAsLevel(1 + noEntityLevel);
-				}
-			}
+		if (!cut) {
+			result.push_back({
+				.from = from,
+				.till = size,
+				.entitiesFrom = firstEntity,
+				.entitiesTill = int(text.entities.size()),
+			});
+			break;
 		}
+		Assert(cut->position > from);
+
+		const auto breaking = cut->inEntity && cut->canBreakEntity;
+		result.push_back({
+			.from = from,
+			.till = cut->position,
+			.entitiesFrom = firstEntity,
+			.entitiesTill = breaking ? (cut->entity + 1) : cut->entity,
+			.clipLastEntity = breaking,
+		});
+		from = cut->position;
+		firstEntity = (cut->inEntity && !cut->canBreakEntity)
+			? (cut->entity + 1)
+			: cut->entity;
+	}
+	return result;
+}
 
-		int elen = 0;
-		if (Ui::Emoji::Find(ch, end, &elen)) {
-			for (int i = 0; i < elen; ++i, ++ch, ++s) {
-				if (ch->isHighSurrogate() && i + 1 < elen && (ch + 1)->isLowSurrogate()) {
-					++ch;
-					++i;
-				}
-			}
-			--ch;
-			--s;
-		} else if (ch->isHighSurrogate() && ch + 1 < end && (ch + 1)->isLowSurrogate()) {
-			++ch;
-		}
-		if (s >= limit) {
-			sending.text = left.text.mid(0, good - start);
-			left.text = left.text.mid(good - start);
-			if (goodInEntity) {
-				if (goodCanBreakEntity) {
-					sending.entities = left.entities.mid(0, goodEntity + 1);
-					sending.entities.back().updateTextEnd(good - start);
-					left.entities = left.entities.mid(goodEntity);
-					for (auto &entity : left.entities) {
-						entity.shiftLeft(good - start);
-					}
-				} else {
-					sending.entities = left.entities.mid(0, goodEntity);
-					left.entities = left.entities.mid(goodEntity + 1);
-				}
-			} else {
-				sending.entities = left.entities.mid(0, goodEntity);
-				left.entities = left.entities.mid(goodEntity);
-				for (auto &entity : left.entities) {
-					entity.shiftLeft(good - start);
-				}
-			}
-			return true;
-		}
+TextWithEntities ExtractPart(
+		const TextWithEntities &text,
+		const TextPartRange &range) {
+	auto result = TextWithEntities{
+		text.text.mid(range.from, range.till - range.from),
+	};
+	result.entities.reserve(range.entitiesTill - range.entitiesFrom);
+	for (auto i = range.entitiesFrom; i != range.entitiesTill; ++i) {
+		result.entities.push_back(text.entities[i]);
+		result.entities.back().shiftLeft(range.from);
 	}
-	sending = base::take(left);
-	return true;
+	if (range.clipLastEntity && !result.entities.isEmpty()) {
+		result.entities.back().updateTextEnd(range.till - range.from);
+	}
+	return result;
 }
 
 MentionNameFields MentionNameDataToFields(QStringView data) {
@@ -379,8 +379,38 @@ QString RemoveAccents(const QString &text);
 QString RemoveEmoji(const QString &text);
 QString NameSortKey(const QString &text);
 QStringList PrepareSearchWords(const QString &query, const QRegularExpression *SplitterOverride = nullptr);
+
+// Allocation free variants for filtering large lists, 'stripEmoji'
+// removes emoji before the normalization, like RemoveEmoji() does.
+void AppendNameSortKey(
+	QStringView text,
+	QString &buffer,
+	bool stripEmoji = false);
+// Words point inside the 'buffer', they are valid till it is changed.
+void PrepareSearchWords(
+	QStringView query,
+	QString &buffer,
+	std::vector<QStringView> &words,
+	bool stripEmoji = false);
 bool CutPart(TextWithEntities &sending, TextWithEntities &left, int limit);
 
+struct TextPartRange {
+	int from = 0;
+	int till = 0;
+	int entitiesFrom = 0;
+	int entitiesTill = 0;
+	bool clipLastEntity = false;
+};
+
+// Same parts as repeated CutPart() calls give, without copying the rest
+// of the text and shifting its entities after each part.
+[[nodiscard]] std::vector<TextPartRange> SplitIntoParts(
+	const TextWithEntities &text,
+	int limit);
+[[nodiscard]] TextWithEntities ExtractPart(
+	const TextWithEntities &text,
+	const TextPartRange &range);
+
 struct MentionNameFields {
 	uint64 selfId = 0;
 	uint64 userId = 0;
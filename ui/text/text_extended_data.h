@@ -115,13 +115,28 @@ struct CustomEmojiData {
 
 };
 
+struct FormattedDateSpan {
+	int32 date = 0;
+	FormattedDateFlags flags;
+	int32 nextUpdate = 0;
+	uint16 position = 0;
+	uint16 length = 0;
+};
+
+struct FormattedDatesData {
+	std::vector<FormattedDateSpan> list;
+	FormattedDateFactory factory;
+	int32 nextUpdate = 0;
+
+};
+
 struct ExtendedData {
 	std::vector<ClickHandlerPtr> links;
 	std::unique_ptr<QuotesData> quotes;
 	std::unique_ptr<SpoilerData> spoiler;
 	std::unique_ptr<CustomEmojiData> customEmoji;
+	std::unique_ptr<FormattedDatesData> formattedDates;
 	std::vector<Modification> modifications;
-	int32 nextFormattedDateUpdate = 0;
 
 };
 
@@ -189,7 +189,8 @@ void Renderer::enumerate() {
 			_t->_startQuoteIndex,
 			UnpackParagraphDirection(
 				_t->_startParagraphLTR,
-				_t->_startParagraphRTL));
+				_t->_startParagraphRTL),
+			_t->_startParagraphSimple);
 	}
 
 	_fontHeight = _t->_st->font->height;
@@ -231,10 +232,13 @@ void Renderer::enumerate() {
 			last_rBearing = 0;
 			_last_rPadding = w->f_rpadding();
 
+			const auto newline = static_cast<const NewlineBlock*>(
+				_t->_blocks[blockIndex].get());
 			initNextParagraph(
 				begin(_t->_blocks) + blockIndex + 1,
 				qindex,
-				static_cast<const NewlineBlock*>(_t->_blocks[blockIndex].get())->paragraphDirection());
+				newline->paragraphDirection(),
+				newline->paragraphSimple());
 
 			_lineStartPadding = _last_rPadding;
 
@@ -460,10 +464,12 @@ crl::time Renderer::now() const {
 void Renderer::initNextParagraph(
 		Blocks::const_iterator i,
 		int16 paragraphIndex,
-		Qt::LayoutDirection direction) {
+		Qt::LayoutDirection direction,
+		bool simple) {
 	_paragraphDirection = (direction == Qt::LayoutDirectionAuto)
 		? style::LayoutDirection()
 		: direction;
+	_paragraphSimple = simple;
 	_paragraphStartBlock = i;
 	if (_quoteIndex != paragraphIndex) {
 		_y += _quotePadding.bottom();
@@ -534,6 +540,14 @@ void Renderer::initParagraphBidi() {
 	}
 
 	_paragraphAnalysis.resize(_paragraphLength);
+	if (_paragraphSimple && _paragraphDirection != Qt::RightToLeft) {
+		// No bidi reordering, same as BidiAlgorithm::process() would do.
+		memset(
+			_paragraphAnalysis.data(),
+			0,
+			_paragraphLength * sizeof(QScriptAnalysis));
+		return;
+	}
 	BidiAlgorithm bidi(
 		_str + _paragraphStart,
 		_paragraphAnalysis.data(),
@@ -761,7 +775,8 @@ bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 		lineText,
 		gsl::span(_paragraphAnalysis).subspan(_localFrom - _paragraphStart),
 		_lineStartBlock,
-		_blocksSize);
+		_blocksSize,
+		_paragraphSimple);
 	auto &e = engine.wrapped();
 
 	int firstItem = e.findItem(lineStart), lastItem = e.findItem(lineStart + lineLength - 1);
@@ -1707,7 +1722,8 @@ void Renderer::prepareElidedLine(
 		lineText,
 		gsl::span(_paragraphAnalysis).subspan(_localFrom - _paragraphStart),
 		_lineStartBlock,
-		_blocksSize);
+		_blocksSize,
+		_paragraphSimple);
 	auto &e = engine.wrapped();
 	_wLeft = _lineWidth
 		- _lineStartPadding
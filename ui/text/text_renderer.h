@@ -59,7 +59,8 @@ private:
 	void initNextParagraph(
 		Blocks::const_iterator i,
 		int16 paragraphIndex,
-		Qt::LayoutDirection direction);
+		Qt::LayoutDirection direction,
+		bool simple);
 	void initNextLine();
 	void resolveLineGeometry(uint16 lineEnd);
 	void initParagraphBidi();
@@ -166,6 +167,7 @@ private:
 	// current paragraph data
 	Blocks::const_iterator _paragraphStartBlock;
 	Qt::LayoutDirection _paragraphDirection = Qt::LayoutDirectionAuto;
+	bool _paragraphSimple = false;
 	int _paragraphStart = 0;
 	int _paragraphLength = 0;
 	QVarLengthArray<QScriptAnalysis, 4096> _paragraphAnalysis;
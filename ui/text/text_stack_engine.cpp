@@ -18,6 +18,35 @@ namespace {
 
 constexpr auto kMaxItemLength = 4096;
 
+// With at most one script apart from Common and Inherited in the text
+// QUnicodeTools::initScripts assigns that script to all the characters,
+// or Common if there are no characters of that script at all.
+[[nodiscard]] QChar::Script ResolveSingleScript(
+		const QChar *chars,
+		int length) {
+	for (auto i = 0; i != length; ++i) {
+		const auto ch = chars[i].unicode();
+		if (ch < 0x80) {
+			if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')) {
+				return QChar::Script_Latin;
+			}
+			continue;
+		}
+		auto ucs4 = char32_t(ch);
+		if (chars[i].isHighSurrogate()
+			&& i + 1 != length
+			&& chars[i + 1].isLowSurrogate()) {
+			ucs4 = QChar::surrogateToUcs4(chars[i], chars[i + 1]);
+			++i;
+		}
+		const auto script = QChar::script(ucs4);
+		if (script > QChar::Script_Common) {
+			return script;
+		}
+	}
+	return QChar::Script_Common;
+}
+
 } // namespace
 
 StackEngine::StackEngine(
@@ -35,7 +64,9 @@ StackEngine::StackEngine(
 			((till < 0) ? int(t->_text.size()) : till) - from)
 		: t->_text),
 	analysis,
-	blockIndexHint) {
+	blockIndexHint,
+	-1,
+	t->_singleScriptLTR) {
 }
 
 StackEngine::StackEngine(
@@ -44,12 +75,14 @@ StackEngine::StackEngine(
 	const QString &text,
 	gsl::span<QScriptAnalysis> analysis,
 	int blockIndexHint,
-	int blockIndexLimit)
+	int blockIndexLimit,
+	bool singleScript)
 : _t(t)
 , _text(text)
 , _analysis(analysis.data())
 , _offset(offset)
 , _positionEnd(_offset + _text.size())
+, _singleScript(singleScript)
 , _font(_t->_st->font)
 , _engine(_text, _font->f)
 , _tBlocks(_t->_blocks)
@@ -100,7 +133,12 @@ void StackEngine::itemize() {
 	_bStart = adjustBlock(_offset);
 	const auto chars = _engine.layoutData->string.constData();
 
-	{
+	if (_singleScript) {
+		const auto script = ResolveSingleScript(chars, length);
+		for (auto i = 0; i != length; ++i) {
+			_analysis[i].script = script;
+		}
+	} else {
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 		QUnicodeTools::ScriptItemArray scriptItems;
 		QUnicodeTools::initScripts(_engine.layoutData->string, &scriptItems);
@@ -26,7 +26,8 @@ public:
 		const QString &text,
 		gsl::span<QScriptAnalysis> analysis,
 		int blockIndexHint = 0,
-		int blockIndexLimit = -1);
+		int blockIndexLimit = -1,
+		bool singleScript = false);
 
 	[[nodiscard]] QTextEngine &wrapped() {
 		return _engine;
@@ -49,6 +50,7 @@ private:
 	QScriptAnalysis *_analysis = nullptr;
 	const int _offset = 0;
 	const int _positionEnd = 0;
+	const bool _singleScript = false;
 	style::font _font;
 	QStackTextEngine _engine;
 
@@ -45,6 +45,9 @@ public:
 	[[nodiscard]] uint16 position() const {
 		return _position;
 	}
+	void setPosition(uint16 position) {
+		_position = position;
+	}
 	[[nodiscard]] QFixed f_rbearing() const {
 		return QFixed::fromFixed(
 			int(_rbearing_modulus) * (_rbearing_positive ? 1 : -1));
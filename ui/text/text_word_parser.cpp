@@ -107,16 +107,25 @@ void WordParser::addNextCluster(
 	++glyphCount;
 }
 
-WordParser::BidiInitedAnalysis::BidiInitedAnalysis(not_null<String*> text)
-: list(text->_text.size()) {
+WordParser::BidiInitedAnalysis::BidiInitedAnalysis(
+	not_null<String*> text,
+	int from,
+	int till,
+	int blockIndex)
+: list(till - from) {
+	if (text->_singleScriptLTR) {
+		// No bidi reordering, same as BidiAlgorithm::process() would do.
+		memset(list.data(), 0, list.size() * sizeof(QScriptAnalysis));
+		return;
+	}
 	BidiAlgorithm bidi(
-		text->_text.constData(),
+		text->_text.constData() + from,
 		list.data(),
-		text->_text.size(),
+		till - from,
 		false, // baseDirectionIsRtl
-		begin(text->_blocks),
+		begin(text->_blocks) + blockIndex,
 		end(text->_blocks),
-		0); // offsetInBlocks
+		from); // offsetInBlocks
 	bidi.process();
 }
 
@@ -125,15 +134,44 @@ WordParser::WordParser(not_null<String*> string)
 , _tText(_t->_text)
 , _tBlocks(_t->_blocks)
 , _tWords(_t->_words)
-, _analysis(_t)
+, _analysis(_t, 0, _tText.size(), 0)
 , _engine(_t, _analysis.list)
 , _e(_engine.wrapped()) {
 	parse();
 }
 
+WordParser::WordParser(
+	not_null<String*> string,
+	int from,
+	int till,
+	std::vector<Word> &words)
+: _t(string)
+, _tText(_t->_text)
+, _tBlocks(_t->_blocks)
+, _tWords(words)
+, _offset(from)
+, _blockIndex(BlockIndexAt(_t, from))
+, _analysis(_t, from, till, _blockIndex)
+, _engine(_t, _analysis.list, from, till, _blockIndex)
+, _e(_engine.wrapped()) {
+	Expects(from >= 0 && from < till && till <= _tText.size());
+
+	parse();
+}
+
+int WordParser::BlockIndexAt(not_null<const String*> string, int position) {
+	const auto &blocks = string->_blocks;
+	const auto i = ranges::upper_bound(
+		blocks,
+		uint16(position),
+		ranges::less(),
+		[](const Block &block) { return block->position(); });
+	return (i == begin(blocks)) ? 0 : int(i - begin(blocks)) - 1;
+}
+
 void WordParser::parse() {
 	_tWords.clear();
-	if (_tText.isEmpty()) {
+	if (_e.layoutData->string.isEmpty()) {
 		return;
 	}
 	_newItem = _e.findItem(0);
@@ -336,7 +374,8 @@ void WordParser::pushFinishedWord(
 		QFixed width,
 		QFixed rbearing) {
 	const auto unfinished = false;
-	_tWords.push_back(Word(position, unfinished, width, rbearing));
+	_tWords.push_back(
+		Word(_offset + position, unfinished, width, rbearing));
 }
 
 void WordParser::pushUnfinishedWord(
@@ -344,11 +383,12 @@ void WordParser::pushUnfinishedWord(
 		QFixed width,
 		QFixed rbearing) {
 	const auto unfinished = true;
-	_tWords.push_back(Word(position, unfinished, width, rbearing));
+	_tWords.push_back(
+		Word(_offset + position, unfinished, width, rbearing));
 }
 
 void WordParser::pushNewline(uint16 position, int newlineBlockIndex) {
-	_tWords.push_back(Word(position, newlineBlockIndex));
+	_tWords.push_back(Word(_offset + position, newlineBlockIndex));
 }
 
 bool WordParser::isLineBreak(
@@ -358,14 +398,16 @@ bool WordParser::isLineBreak(
 	// In case of a line break or white space it'll allow break anyway.
 	return attributes[index].lineBreak
 		&& (index <= 0
-			|| (_tText[index - 1] != '/' && _tText[index - 1] != '.'));
+			|| (_tText[_offset + index - 1] != '/'
+				&& _tText[_offset + index - 1] != '.'));
 }
 
 bool WordParser::isSpaceBreak(
 		const QCharAttributes *attributes,
 		int index) const {
 	// Don't break on &nbsp;
-	return attributes[index].whiteSpace && (_tText[index] != QChar::Nbsp);
+	return attributes[index].whiteSpace
+		&& (_tText[_offset + index] != QChar::Nbsp);
 }
 
 } // namespace Ui::Text
@@ -20,6 +20,14 @@ class WordParser {
 public:
 	explicit WordParser(not_null<String*> string);
 
+	// Parses only [from, till) range of the text into 'words'.
+	// The range should start at a paragraph start (or its newline).
+	WordParser(
+		not_null<String*> string,
+		int from,
+		int till,
+		std::vector<Word> &words);
+
 private:
 	struct ScriptLine {
 		int length = 0;
@@ -68,7 +76,11 @@ private:
 
 	};
 	struct BidiInitedAnalysis {
-		explicit BidiInitedAnalysis(not_null<String*> text);
+		BidiInitedAnalysis(
+			not_null<String*> text,
+			int from,
+			int till,
+			int blockIndex);
 
 		QVarLengthArray<QScriptAnalysis, 4096> list;
 	};
@@ -104,10 +116,16 @@ private:
 		const QCharAttributes *attributes,
 		int index) const;
 
+	[[nodiscard]] static int BlockIndexAt(
+		not_null<const String*> string,
+		int position);
+
 	const not_null<String*> _t;
 	QString &_tText;
 	std::vector<Block> &_tBlocks;
 	std::vector<Word> &_tWords;
+	const int _offset = 0;
+	const int _blockIndex = 0;
 	BidiInitedAnalysis _analysis;
 	StackEngine _engine;
 	QTextEngine &_e;
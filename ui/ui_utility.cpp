@@ -7,7 +7,9 @@
 #include "ui/ui_utility.h"
 
 #include "base/platform/base_platform_info.h"
+#include "base/flat_map.h"
 #include "ui/integration.h"
+#include "ui/rp_widget.h"
 #include "ui/style/style_core.h"
 
 #include <QtWidgets/QApplication>
@@ -23,6 +25,19 @@ namespace {
 constexpr auto kDefaultWheelScrollLines = 3;
 constexpr auto kMagicScrollMultiplier = 2.5;
 
+// Subtree roots that may hold widgets with pending move / resize events.
+using PendingFrontier = base::flat_map<QWidget*, QPointer<QWidget>>;
+
+struct PendingTracking {
+	PendingFrontier frontier;
+	QMetaObject::Connection destroyed;
+	uint64 id = 0;
+	bool valid = false;
+};
+
+auto PendingTracked = base::flat_map<QWidget*, PendingTracking>();
+auto PendingTrackingAutoincrement = uint64();
+
 class WidgetCreator : public QWidget {
 public:
 	static void Create(not_null<QWidget*> widget) {
@@ -41,7 +56,19 @@ void CreateWidgetStateRecursive(not_null<QWidget*> target) {
 	}
 }
 
-void SendPendingEventsRecursive(QWidget *target, bool parentHiddenFlag) {
+// While the target is visible, only hidden widgets and their subtrees
+// can get pending events. Hidden RpWidget-s and newly added children
+// report themselves through MarkPendingMoveResize(), other widgets can't,
+// so they are kept in the frontier forever.
+[[nodiscard]] bool IsPendingFrontier(not_null<QWidget*> widget) {
+	return widget->testAttribute(Qt::WA_WState_Hidden)
+		|| !dynamic_cast<RpWidgetWrap*>(widget.get());
+}
+
+void SendPendingEventsRecursive(
+		QWidget *target,
+		bool parentHiddenFlag,
+		PendingFrontier *frontier = nullptr) {
 	auto wasVisible = target->isVisible();
 	if (!wasVisible) {
 		target->setAttribute(Qt::WA_WState_Visible, true);
@@ -71,7 +98,15 @@ void SendPendingEventsRecursive(QWidget *target, bool parentHiddenFlag) {
 				if (!widget->testAttribute(Qt::WA_WState_Created)) {
 					WidgetCreator::Create(widget);
 				}
-				SendPendingEventsRecursive(widget, removeVisibleFlag());
+				if (frontier && IsPendingFrontier(widget)) {
+					frontier->emplace(widget, widget);
+					SendPendingEventsRecursive(widget, removeVisibleFlag());
+				} else {
+					SendPendingEventsRecursive(
+						widget,
+						removeVisibleFlag(),
+						frontier);
+				}
 			}
 		}
 	}
@@ -100,7 +135,84 @@ bool InFocusChain(not_null<const QWidget*> widget) {
 
 void SendPendingMoveResizeEvents(not_null<QWidget*> target) {
 	CreateWidgetStateRecursive(target);
-	SendPendingEventsRecursive(target, !target->isVisible());
+
+	const auto i = PendingTracked.find(target.get());
+	if (i == end(PendingTracked) || !target->isVisible()) {
+		if (i != end(PendingTracked)) {
+			i->second.valid = false;
+		}
+		SendPendingEventsRecursive(target, !target->isVisible());
+		return;
+	}
+	const auto id = i->second.id;
+	const auto valid = i->second.valid;
+	auto roots = base::take(i->second.frontier);
+	i->second.valid = true;
+
+	// Event handlers may add new marks or stop tracking, so we collect
+	// the new frontier separately and merge it in the end.
+	auto collected = PendingFrontier();
+	const auto weak = QPointer<QWidget>(target.get());
+	if (!valid) {
+		SendPendingEventsRecursive(target, false, &collected);
+	} else {
+		for (const auto &[raw, root] : roots) {
+			if (!weak) {
+				return;
+			} else if (!root || !target->isAncestorOf(root)) {
+				continue;
+			}
+			CreateWidgetStateRecursive(root);
+			const auto hidden = !root->parentWidget()->isVisible();
+			if (IsPendingFrontier(root)) {
+				collected.emplace(root, root);
+				SendPendingEventsRecursive(root, hidden);
+			} else {
+				SendPendingEventsRecursive(root, hidden, &collected);
+			}
+		}
+	}
+	const auto j = PendingTracked.find(target.get());
+	if (!weak || j == end(PendingTracked) || j->second.id != id) {
+		return;
+	}
+	for (auto &[raw, root] : collected) {
+		j->second.frontier[raw] = std::move(root);
+	}
+}
+
+rpl::lifetime TrackPendingMoveResizeEvents(not_null<QWidget*> target) {
+	Expects(!PendingTracked.contains(target.get()));
+
+	const auto raw = target.get();
+	const auto id = ++PendingTrackingAutoincrement;
+	const auto stop = [=] {
+		const auto i = PendingTracked.find(raw);
+		if (i != end(PendingTracked) && i->second.id == id) {
+			QObject::disconnect(i->second.destroyed);
+			PendingTracked.erase(i);
+		}
+	};
+	PendingTracked.emplace(raw, PendingTracking{
+		.destroyed = QObject::connect(raw, &QObject::destroyed, stop),
+		.id = id,
+	});
+	return rpl::lifetime(stop);
+}
+
+void MarkPendingMoveResize(not_null<QWidget*> widget) {
+	if (PendingTracked.empty()) {
+		return;
+	}
+	const auto raw = widget.get();
+	for (auto parent = raw->parentWidget()
+		; parent
+		; parent = parent->parentWidget()) {
+		const auto i = PendingTracked.find(parent);
+		if (i != end(PendingTracked) && i->second.valid) {
+			i->second.frontier[raw] = raw;
+		}
+	}
 }
 
 void MarkDirtyOpaqueChildrenRecursive(not_null<QWidget*> target) {
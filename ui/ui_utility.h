@@ -9,6 +9,7 @@
 #include "base/unique_qptr.h"
 
 #include <crl/crl.h>
+#include <rpl/lifetime.h>
 #include <QtCore/QEvent>
 #include <QtWidgets/QWidget>
 
@@ -65,6 +66,15 @@ inline ChildWidget *AttachParentChild(
 
 void SendPendingMoveResizeEvents(not_null<QWidget*> target);
 
+// While the returned lifetime is alive, SendPendingMoveResizeEvents()
+// for the visible 'target' visits only the subtrees that could have
+// received pending events since the last call, not the whole subtree.
+[[nodiscard]] rpl::lifetime TrackPendingMoveResizeEvents(
+	not_null<QWidget*> target);
+
+// RpWidget-s report here when they are added to a parent or hidden.
+void MarkPendingMoveResize(not_null<QWidget*> widget);
+
 [[nodiscard]] QPixmap GrabWidget(
 	not_null<QWidget*> target,
 	QRect rect = QRect(),
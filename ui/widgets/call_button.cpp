@@ -6,6 +6,7 @@
 //
 #include "ui/widgets/call_button.h"
 
+#include "ui/effects/keyframe_cache.h"
 #include "ui/effects/ripple_animation.h"
 #include "ui/painter.h"
 #include "ui/widgets/labels.h"
@@ -56,8 +57,6 @@ void CallButton::init() {
 		_bg = QImage(_bgMask.size(), QImage::Format_ARGB32_Premultiplied);
 		_bg.setDevicePixelRatio(style::DevicePixelRatio());
 		_bgTo = Ui::PixmapFromImage(style::colorizeImage(_bgMask, _stTo->bg));
-		_iconMixedMask = QImage(_bgMask.size(), QImage::Format_ARGB32_Premultiplied);
-		_iconMixedMask.setDevicePixelRatio(style::DevicePixelRatio());
 		_iconFrom = QImage(_bgMask.size(), QImage::Format_ARGB32_Premultiplied);
 		_iconFrom.setDevicePixelRatio(style::DevicePixelRatio());
 		_iconFrom.fill(Qt::black);
@@ -187,8 +186,20 @@ void CallButton::paintEvent(QPaintEvent *e) {
 		if (paintTo) {
 			_stTo->button.icon.paint(p, positionTo, width());
 		} else {
-			mixIconMasks();
-			style::colorizeImage(_iconMixedMask, st::callIconFg->c, &_iconMixed);
+			const auto angle = [](float64 value) {
+				return uint64(uint32(int(base::SafeRound(value * 65536))));
+			};
+			const auto mask = Keyframe({
+				.style = _stFrom->button.icon.cacheKey(),
+				.variant = _stTo->button.icon.cacheKey(),
+				.extra = (angle(_stFrom->angle) << 32) | angle(_stTo->angle),
+				.width = _bgMask.width(),
+				.height = _bgMask.height(),
+				.ratio = style::DevicePixelRatio(),
+			}, _progress, [&](float64 progress) {
+				return mixIconMasks(progress);
+			});
+			style::colorizeImage(mask, st::callIconFg->c, &_iconMixed);
 			p.drawImage(myrtlpoint(_stFrom->bgPosition), _iconMixed);
 		}
 	}
@@ -205,10 +216,14 @@ QPoint CallButton::iconPosition(not_null<const style::CallButton*> st) const {
 	return result;
 }
 
-void CallButton::mixIconMasks() {
-	_iconMixedMask.fill(Qt::black);
+QImage CallButton::mixIconMasks(float64 progress) const {
+	auto result = QImage(
+		_bgMask.size(),
+		QImage::Format_ARGB32_Premultiplied);
+	result.setDevicePixelRatio(style::DevicePixelRatio());
+	result.fill(Qt::black);
 
-	Painter p(&_iconMixedMask);
+	Painter p(&result);
 	PainterHighQualityEnabler hq(p);
 	auto paintIconMask = [this, &p](const QImage &mask, float64 angle) {
 		auto skipFrom = _stFrom->bgSize / 2;
@@ -218,10 +233,13 @@ void CallButton::mixIconMasks() {
 		p.drawImage(0, 0, mask);
 	};
 	p.save();
-	paintIconMask(_iconFrom, (_stFrom->angle - _stTo->angle) * _progress);
+	paintIconMask(_iconFrom, (_stFrom->angle - _stTo->angle) * progress);
 	p.restore();
-	p.setOpacity(_progress);
-	paintIconMask(_iconTo, (_stTo->angle - _stFrom->angle) * (1. - _progress));
+	p.setOpacity(progress);
+	paintIconMask(_iconTo, (_stTo->angle - _stFrom->angle) * (1. - progress));
+	p.end();
+
+	return result;
 }
 
 void CallButton::onStateChanged(State was, StateChangeSource source) {
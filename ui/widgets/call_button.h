@@ -49,7 +49,7 @@ private:
 
 	void init();
 	QPoint iconPosition(not_null<const style::CallButton*> st) const;
-	void mixIconMasks();
+	[[nodiscard]] QImage mixIconMasks(float64 progress) const;
 
 	not_null<const style::CallButton*> _stFrom;
 	const style::CallButton *_stTo = nullptr;
@@ -63,7 +63,7 @@ private:
 
 	QImage _bgMask, _bg;
 	QPixmap _bgFrom, _bgTo;
-	QImage _iconMixedMask, _iconFrom, _iconTo, _iconMixed;
+	QImage _iconFrom, _iconTo, _iconMixed;
 
 	float64 _outerValue = 0.;
 	Animations::Simple _outerAnimation;
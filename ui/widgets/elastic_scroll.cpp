@@ -392,7 +392,9 @@ ElasticScroll::ElasticScroll(
 , _st(st)
 , _bar(std::make_unique<ElasticScrollBar>(this, _st, orientation))
 , _touchTimer([=] { _touchRightButton = true; })
-, _touchScrollTimer([=] { touchScrollTimer(); })
+, _touchScrollAnimation([=](crl::time now) {
+	return touchScrollFrame(now);
+})
 , _vertical(orientation == Qt::Vertical)
 , _position(Position{ 0, 0 })
 , _movement(Movement::None) {
@@ -489,13 +491,6 @@ QWidget *ElasticScroll::viewport() const {
 	return _widget;
 }
 
-void ElasticScroll::touchDeaccelerate(int32 elapsed) {
-	int32 x = _touchSpeed.x();
-	int32 y = _touchSpeed.y();
-	_touchSpeed.setX((x == 0) ? x : (x > 0) ? qMax(0, x - elapsed) : qMin(0, x + elapsed));
-	_touchSpeed.setY((y == 0) ? y : (y > 0) ? qMax(0, y - elapsed) : qMin(0, y + elapsed));
-}
-
 void ElasticScroll::overscrollReturn() {
 	_overscrollReturning = true;
 	_ignoreMomentumFromOverscroll = _overscroll;
@@ -607,73 +602,36 @@ int ElasticScroll::scrollTop() const {
 	return _vertical ? _state.visibleFrom : 0;
 }
 
-void ElasticScroll::touchScrollTimer() {
-	auto nowTime = crl::now();
-	if (_touchScrollState == TouchScrollState::Acceleration && _touchWaitingAcceleration && (nowTime - _touchAccelerationTime) > 40) {
+bool ElasticScroll::touchScrollFrame(crl::time now) {
+	if (_touchScrollState == TouchScrollState::Acceleration
+		&& _touchWaitingAcceleration
+		&& (now - _touchAccelerationTime) > kTouchAccelerationTimeout) {
 		_touchScrollState = TouchScrollState::Manual;
 		sendWheelEvent(Qt::ScrollEnd);
-		touchResetSpeed();
-	} else if (_touchScrollState == TouchScrollState::Auto || _touchScrollState == TouchScrollState::Acceleration) {
-		int32 elapsed = int32(nowTime - _touchTime);
-		QPoint delta = _touchSpeed * elapsed / 1000;
+		_touchFling.stop();
+		return false;
+	} else if (_touchScrollState == TouchScrollState::Manual) {
+		_touchFling.stop();
+		return false;
+	}
+	const auto delta = _touchFling.advance(now);
+	if (!delta.isNull()) {
 		sendWheelEvent(
 			_touchPress ? Qt::ScrollUpdate : Qt::ScrollMomentum,
 			delta);
-
-		if (_touchSpeed.isNull()) {
-			_touchScrollState = TouchScrollState::Manual;
-			sendWheelEvent(Qt::ScrollEnd);
-			_touchScroll = false;
-			_touchScrollTimer.cancel();
-		} else {
-			_touchTime = nowTime;
-		}
-		touchDeaccelerate(elapsed);
-	}
-}
-
-void ElasticScroll::touchUpdateSpeed() {
-	const auto nowTime = crl::now();
-	if (_touchPreviousPositionValid) {
-		const int elapsed = nowTime - _touchSpeedTime;
-		if (elapsed) {
-			const QPoint newPixelDiff = (_touchPosition - _touchPreviousPosition);
-			const QPoint pixelsPerSecond = newPixelDiff * (1000 / elapsed);
-
-			// fingers are inacurates, we ignore small changes to avoid stopping the autoscroll because
-			// of a small horizontal offset when scrolling vertically
-			const int newSpeedY = (qAbs(pixelsPerSecond.y()) > kFingerAccuracyThreshold) ? pixelsPerSecond.y() : 0;
-			const int newSpeedX = (qAbs(pixelsPerSecond.x()) > kFingerAccuracyThreshold) ? pixelsPerSecond.x() : 0;
-			if (_touchScrollState == TouchScrollState::Auto) {
-				const int oldSpeedY = _touchSpeed.y();
-				const int oldSpeedX = _touchSpeed.x();
-				if ((oldSpeedY <= 0 && newSpeedY <= 0) || ((oldSpeedY >= 0 && newSpeedY >= 0)
-					&& (oldSpeedX <= 0 && newSpeedX <= 0)) || (oldSpeedX >= 0 && newSpeedX >= 0)) {
-					_touchSpeed.setY(std::clamp((oldSpeedY + (newSpeedY / 4)), -kMaxScrollAccelerated, +kMaxScrollAccelerated));
-					_touchSpeed.setX(std::clamp((oldSpeedX + (newSpeedX / 4)), -kMaxScrollAccelerated, +kMaxScrollAccelerated));
-				} else {
-					_touchSpeed = QPoint();
-				}
-			} else {
-				// we average the speed to avoid strange effects with the last delta
-				if (!_touchSpeed.isNull()) {
-					_touchSpeed.setX(std::clamp((_touchSpeed.x() / 4) + (newSpeedX * 3 / 4), -kMaxScrollFlick, +kMaxScrollFlick));
-					_touchSpeed.setY(std::clamp((_touchSpeed.y() / 4) + (newSpeedY * 3 / 4), -kMaxScrollFlick, +kMaxScrollFlick));
-				} else {
-					_touchSpeed = QPoint(newSpeedX, newSpeedY);
-				}
-			}
-		}
-	} else {
-		_touchPreviousPositionValid = true;
 	}
-	_touchSpeedTime = nowTime;
-	_touchPreviousPosition = _touchPosition;
+	if (!_touchFling.active()) {
+		_touchScrollState = TouchScrollState::Manual;
+		sendWheelEvent(Qt::ScrollEnd);
+		_touchScroll = false;
+		return false;
+	}
+	return true;
 }
 
-void ElasticScroll::touchResetSpeed() {
-	_touchSpeed = QPoint();
-	_touchPreviousPositionValid = false;
+void ElasticScroll::touchScrollStop() {
+	_touchFling.stop();
+	_touchScrollAnimation.stop();
 }
 
 bool ElasticScroll::eventHook(QEvent *e) {
@@ -1027,6 +985,7 @@ bool ElasticScroll::filterOutTouchEvent(QEvent *e) {
 }
 
 void ElasticScroll::handleTouchEvent(QTouchEvent *e) {
+	const auto now = crl::now();
 	if (!e->touchPoints().isEmpty()) {
 		_touchPreviousPosition = _touchPosition;
 		_touchPosition = e->touchPoints().cbegin()->screenPos().toPoint();
@@ -1038,13 +997,13 @@ void ElasticScroll::handleTouchEvent(QTouchEvent *e) {
 			return;
 		}
 		_touchPress = true;
+		_touchFling.clearSamples();
+		_touchFling.addSample(_touchPosition, now);
 		if (_touchScrollState == TouchScrollState::Auto) {
 			_touchScrollState = TouchScrollState::Acceleration;
 			_touchMaybePressing = false;
 			_touchWaitingAcceleration = true;
-			_touchAccelerationTime = crl::now();
-			touchUpdateSpeed();
-			_touchStart = _touchPosition;
+			_touchAccelerationTime = now;
 		} else {
 			_touchScroll = false;
 			_touchMaybePressing = true;
@@ -1059,21 +1018,21 @@ void ElasticScroll::handleTouchEvent(QTouchEvent *e) {
 		if (!_touchPress) {
 			return;
 		}
+		_touchFling.addSample(_touchPosition, now);
 		if (!_touchScroll
 			&& ((_touchPosition - _touchStart).manhattanLength()
 				>= QApplication::startDragDistance())) {
 			_touchTimer.cancel();
 			_touchScroll = true;
 			_touchMaybePressing = false;
-			touchUpdateSpeed();
 		}
 		if (_touchScroll) {
 			if (_touchScrollState == TouchScrollState::Manual) {
 				touchScrollUpdated();
 			} else if (_touchScrollState == TouchScrollState::Acceleration) {
-				touchUpdateSpeed();
-				_touchAccelerationTime = crl::now();
-				if (_touchSpeed.isNull()) {
+				_touchAccelerationTime = now;
+				_touchFling.follow(_touchFling.estimateVelocity(now), now);
+				if (!_touchFling.active()) {
 					_touchScrollState = TouchScrollState::Manual;
 				}
 			}
@@ -1088,18 +1047,21 @@ void ElasticScroll::handleTouchEvent(QTouchEvent *e) {
 		auto weak = base::make_weak(this);
 		if (_touchScroll) {
 			if (_touchScrollState == TouchScrollState::Manual) {
-				_touchScrollState = TouchScrollState::Auto;
-				_touchPreviousPositionValid = false;
-				_touchScrollTimer.callEach(15);
-				_touchTime = crl::now();
+				_touchFling.start(_touchFling.estimateVelocity(now), now);
+				if (_touchFling.active()) {
+					_touchScrollState = TouchScrollState::Auto;
+					_touchScrollAnimation.start();
+				} else {
+					sendWheelEvent(Qt::ScrollEnd);
+					_touchScroll = false;
+				}
 			} else if (_touchScrollState == TouchScrollState::Auto) {
 				_touchScrollState = TouchScrollState::Manual;
 				_touchScroll = false;
-				touchResetSpeed();
+				touchScrollStop();
 			} else if (_touchScrollState == TouchScrollState::Acceleration) {
 				_touchScrollState = TouchScrollState::Auto;
 				_touchWaitingAcceleration = false;
-				_touchPreviousPositionValid = false;
 			}
 		} else if (window()) { // one short tap -- like left mouse click, one long tap -- like right mouse click
 			Qt::MouseButton btn(_touchRightButton ? Qt::RightButton : Qt::LeftButton);
@@ -1129,6 +1091,7 @@ void ElasticScroll::handleTouchEvent(QTouchEvent *e) {
 		_touchMaybePressing = false;
 		_touchScrollState = TouchScrollState::Manual;
 		_touchTimer.cancel();
+		touchScrollStop();
 	} break;
 	}
 }
@@ -1139,7 +1102,6 @@ void ElasticScroll::touchScrollUpdated() {
 		? Qt::ScrollMomentum
 		: Qt::ScrollUpdate;
 	sendWheelEvent(phase, _touchPosition - _touchPreviousPosition);
-	touchUpdateSpeed();
 }
 
 void ElasticScroll::disableScroll(bool dis) {
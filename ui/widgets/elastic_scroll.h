@@ -267,14 +267,11 @@ private:
 	object_ptr<QWidget> doTakeWidget();
 
 	bool filterOutTouchEvent(QEvent *e);
-	void touchScrollTimer();
+	bool touchScrollFrame(crl::time now);
 	void touchScrollUpdated();
+	void touchScrollStop();
 	void sendWheelEvent(Qt::ScrollPhase phase, QPoint delta = {});
 
-	void touchResetSpeed();
-	void touchUpdateSpeed();
-	void touchDeaccelerate(int32 elapsed);
-
 	struct AccumulatedParts {
 		int base = 0;
 		int relative = 0;
@@ -299,14 +296,12 @@ private:
 	QPoint _wheelPos;
 
 	base::Timer _touchTimer;
-	base::Timer _touchScrollTimer;
+	TouchFling _touchFling;
+	Animations::Basic _touchScrollAnimation;
 	QPoint _touchStart;
 	QPoint _touchPreviousPosition;
 	QPoint _touchPosition;
-	QPoint _touchSpeed;
-	crl::time _touchSpeedTime = 0;
 	crl::time _touchAccelerationTime = 0;
-	crl::time _touchTime = 0;
 	crl::time _lastScroll = 0;
 	rpl::variable<bool> _touchMaybePressing;
 	TouchScrollState _touchScrollState = TouchScrollState::Manual;
@@ -316,7 +311,6 @@ private:
 	bool _touchScroll : 1 = false;
 	bool _touchPress : 1 = false;
 	bool _touchRightButton : 1 = false;
-	bool _touchPreviousPositionValid : 1 = false;
 	bool _touchWaitingAcceleration : 1 = false;
 	bool _vertical : 1 = false;
 	bool _widgetAcceptsTouch : 1 = false;
@@ -36,6 +36,7 @@ public:
 
 private:
 	void paintEvent(QPaintEvent *e) override;
+	void repaintSpoilers();
 
 	const not_null<InputField*> _field;
 	const Fn<float64()> _shown;
@@ -52,11 +53,22 @@ FieldSpoilerOverlay::FieldSpoilerOverlay(
 , _field(field)
 , _shown(std::move(shown))
 , _paused(std::move(paused))
-, _animation([=] { update(); }) {
+, _animation([=] { repaintSpoilers(); }) {
 	setAttribute(Qt::WA_TransparentForMouseEvents);
 	show();
 }
 
+void FieldSpoilerOverlay::repaintSpoilers() {
+	auto region = QRegion();
+	const auto bounds = rect();
+	for (const auto &rect : _field->_spoilerRects) {
+		region += rect.geometry.intersected(bounds);
+	}
+	if (!region.isEmpty()) {
+		update(region);
+	}
+}
+
 void FieldSpoilerOverlay::paintEvent(QPaintEvent *e) {
 	auto p = std::optional<QPainter>();
 	auto topShift = std::optional<int>();
@@ -151,6 +163,10 @@ void CustomFieldObject::drawObject(
 		QTextDocument *doc,
 		int posInDocument,
 		const QTextFormat &format) {
+	if (_recordDrawn
+		&& painter->device() == _field->rawTextEdit()->viewport()) {
+		_drawn.push_back(rect.toAlignedRect());
+	}
 	if (format.objectType() == InputField::kCollapsedQuoteFormat) {
 		const auto left = 0;
 		const auto top = 0;
@@ -287,7 +303,7 @@ const TextWithTags &CustomFieldObject::collapsedText(int quoteId) const {
 
 Text::MarkedContext CustomFieldObject::makeFieldContext() {
 	auto context = _context;
-	context.repaint = [field = _field] { field->update(); };
+	context.repaint = [field = _field] { field->customEmojiRepaint(); };
 	return context;
 }
 
@@ -301,4 +317,33 @@ void CustomFieldObject::setNow(crl::time now) {
 	_now = now;
 }
 
+void CustomFieldObject::paintStarted(
+		const QRegion &clip,
+		bool full,
+		int revision) {
+	if (full) {
+		_drawn.clear();
+		_drawnRevision = revision;
+	} else if (_drawnRevision != revision) {
+		_drawn.clear();
+		_drawnRevision = -1;
+	} else {
+		_drawn.erase(ranges::remove_if(_drawn, [&](const QRect &rect) {
+			return clip.intersects(rect);
+		}), end(_drawn));
+	}
+	_recordDrawn = (_drawnRevision >= 0);
+}
+
+std::optional<QRegion> CustomFieldObject::drawnRegion(int revision) const {
+	if (_drawnRevision < 0 || _drawnRevision != revision) {
+		return std::nullopt;
+	}
+	auto result = QRegion();
+	for (const auto &rect : _drawn) {
+		result += rect;
+	}
+	return result;
+}
+
 } // namespace Ui
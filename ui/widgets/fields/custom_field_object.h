@@ -45,6 +45,12 @@ public:
 
 	void setNow(crl::time now);
 
+	// Objects drawn in the viewport are remembered in document coordinates,
+	// so that animations can repaint only them. A paint after the contents
+	// were changed forgets everything until the viewport is fully painted.
+	void paintStarted(const QRegion &clip, bool full, int revision);
+	[[nodiscard]] std::optional<QRegion> drawnRegion(int revision) const;
+
 	void clearEmoji();
 	void clearQuotes();
 
@@ -72,6 +78,10 @@ private:
 	crl::time _now = 0;
 	int _skip = 0;
 
+	std::vector<QRect> _drawn;
+	int _drawnRevision = -1;
+	bool _recordDrawn = false;
+
 	Animations::Simple _spoilerOpacity;
 	bool _spoilerHidden = false;
 
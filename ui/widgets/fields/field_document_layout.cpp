@@ -0,0 +1,81 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/widgets/fields/field_document_layout.h"
+
+#include <QtGui/QTextDocument>
+
+namespace Ui {
+namespace {
+
+constexpr auto kLazyLayoutMinLength = 16 * 1024;
+constexpr auto kProgressCheckInterval = crl::time(40);
+
+} // namespace
+
+FieldDocumentLayout::FieldDocumentLayout(not_null<QTextDocument*> document)
+: QTextDocumentLayout(document)
+, _progressTimer([=] { checkProgress(); }) {
+}
+
+bool FieldDocumentLayout::lazy() const {
+	return (layoutStatus() < 100);
+}
+
+QSizeF FieldDocumentLayout::estimatedSize() const {
+	const auto status = layoutStatus();
+	if (status >= 100) {
+		return documentSize();
+	}
+	const auto size = dynamicDocumentSize();
+	if (status <= 0) {
+		return size;
+	}
+	return QSizeF(size.width(), size.height() * 100. / status);
+}
+
+int FieldDocumentLayout::laidOutPosition() const {
+	const auto status = layoutStatus();
+	if (status >= 100) {
+		return std::numeric_limits<int>::max();
+	}
+	return int(int64(document()->characterCount()) * status / 100);
+}
+
+rpl::producer<> FieldDocumentLayout::lazyProgress() const {
+	return _lazyProgress.events();
+}
+
+void FieldDocumentLayout::documentChanged(
+		int from,
+		int oldLength,
+		int length) {
+	const auto full = document()->characterCount();
+	if (std::max(oldLength, length) < kLazyLayoutMinLength
+		|| full < kLazyLayoutMinLength) {
+		QTextDocumentLayout::documentChanged(from, oldLength, length);
+	} else {
+		// A change covering the whole document is laid out lazily.
+		QTextDocumentLayout::documentChanged(0, 0, full);
+	}
+	if (lazy() && !_progressTimer.isActive()) {
+		_lastStatus = layoutStatus();
+		_progressTimer.callEach(kProgressCheckInterval);
+	}
+}
+
+void FieldDocumentLayout::checkProgress() {
+	const auto status = layoutStatus();
+	if (status >= 100) {
+		_progressTimer.cancel();
+	}
+	if (_lastStatus != status) {
+		_lastStatus = status;
+		_lazyProgress.fire({});
+	}
+}
+
+} // namespace Ui
@@ -0,0 +1,50 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "base/timer.h"
+
+#include <rpl/event_stream.h>
+
+#include <private/qtextdocumentlayout_p.h>
+
+namespace Ui {
+
+// Document layout for large drafts.
+//
+// Big changes (pasting or restoring a huge draft) are not laid out
+// synchronously. Instead the whole document is scheduled for the lazy
+// relayout of QTextDocumentLayout, which lays out the blocks up to the
+// painted viewport right away and the rest in steps from the event loop.
+// Until it converges the document height is estimated from the progress.
+class FieldDocumentLayout final : public QTextDocumentLayout {
+public:
+	explicit FieldDocumentLayout(not_null<QTextDocument*> document);
+
+	[[nodiscard]] bool lazy() const;
+	[[nodiscard]] QSizeF estimatedSize() const;
+
+	// Blocks ending before this position may be queried without forcing
+	// the layout of the rest of the document.
+	[[nodiscard]] int laidOutPosition() const;
+
+	// Fires while the lazy layout advances and once when it converges.
+	[[nodiscard]] rpl::producer<> lazyProgress() const;
+
+protected:
+	void documentChanged(int from, int oldLength, int length) override;
+
+private:
+	void checkProgress();
+
+	base::Timer _progressTimer;
+	rpl::event_stream<> _lazyProgress;
+	int _lastStatus = 100;
+
+};
+
+} // namespace Ui
@@ -19,6 +19,7 @@
 #include "ui/basic_click_handlers.h"
 #include "ui/text/text_renderer.h" // kQuoteCollapsedLines
 #include "ui/widgets/fields/custom_field_object.h"
+#include "ui/widgets/fields/field_document_layout.h"
 #include "ui/widgets/labels.h"
 #include "ui/widgets/popup_menu.h"
 #include "ui/emoji_config.h"
@@ -1896,10 +1897,19 @@ InputField::InputField(
 	_inner->setContentsMargins(0, 0, 0, 0);
 	_inner->document()->setDocumentMargin(0);
 
+	_documentLayout = new FieldDocumentLayout(_inner->document());
+	_inner->document()->setDocumentLayout(_documentLayout);
+	_documentLayout->lazyProgress(
+	) | rpl::on_next([=] {
+		++_paintGeometryRevision;
+		checkContentHeight();
+	}, lifetime());
+
 	base::qt_signal_producer(
 		_inner->document(),
 		&QTextDocument::contentsChange
 	) | rpl::on_next([=](int position, int removed, int added) {
+		++_paintGeometryRevision;
 		documentContentsChanged(position, removed, added);
 	}, lifetime());
 	base::qt_signal_producer(
@@ -2074,7 +2084,14 @@ void InputField::setBlockquoteCache(
 
 bool InputField::viewportEventInner(QEvent *e) {
 	if (e->type() == QEvent::Paint && _customObject) {
+		const auto viewport = _inner->viewport();
+		const auto &region = static_cast<QPaintEvent*>(e)->region();
+		const auto full = (QRegion(viewport->rect()) - region).isEmpty();
 		_customObject->setNow(crl::now());
+		_customObject->paintStarted(
+			region.translated(documentOffset()),
+			full,
+			_paintGeometryRevision);
 	}
 	return _inner->QTextEdit::viewportEvent(e);
 }
@@ -2225,41 +2242,58 @@ void InputField::customEmojiRepaint() {
 	if (_customEmojiRepaintScheduled) {
 		return;
 	}
-	_customEmojiRepaintScheduled = true;
-	_inner->update();
+	const auto viewport = _inner->viewport();
+	const auto drawn = _customObject
+		? _customObject->drawnRegion(_paintGeometryRevision)
+		: std::nullopt;
+	if (!drawn) {
+		_customEmojiRepaintScheduled = true;
+		viewport->update();
+		return;
+	}
+	const auto region = drawn->translated(-documentOffset())
+		& viewport->rect();
+	if (!region.isEmpty()) {
+		_customEmojiRepaintScheduled = true;
+		viewport->update(region);
+	}
+}
+
+QPoint InputField::documentOffset() const {
+	return QPoint(
+		_inner->horizontalScrollBar()->value(),
+		_inner->verticalScrollBar()->value());
 }
 
 void InputField::paintEventInner(QPaintEvent *e) {
 	_customEmojiRepaintScheduled = false;
+	if (_documentLayout->lazy()) {
+		// Lay out the visible blocks before computing their decorations.
+		_documentLayout->ensureLayouted(
+			documentOffset().y() + _inner->viewport()->height());
+	}
 	paintQuotes(e);
 	_inner->QTextEdit::paintEvent(e);
 }
 
-void InputField::paintQuotes(QPaintEvent *e) {
-	if (!_blockquoteCache || !_preCache) {
+void InputField::refreshPaintGeometry() {
+	const auto document = _inner->document();
+	const auto documentLayout = _documentLayout;
+	const auto width = _inner->viewport()->width();
+	const auto size = documentLayout->dynamicDocumentSize();
+	const auto laidOut = documentLayout->laidOutPosition();
+	auto &cache = _paintGeometry;
+	if (cache.revision == _paintGeometryRevision
+		&& cache.width == width
+		&& cache.size == size) {
 		return;
 	}
-	const auto clip = e->rect();
-
-	auto p = std::optional<QPainter>();
-	const auto ensurePainter = [&] {
-		if (!p) {
-			p.emplace(_inner->viewport());
-		}
-	};
-
-	auto shift = std::optional<QPoint>();
-	const auto ensureShift = [&] {
-		if (!shift) {
-			shift.emplace(
-				-_inner->horizontalScrollBar()->value(),
-				-_inner->verticalScrollBar()->value());
-		}
-	};
-
-	const auto document = _inner->document();
-	const auto documentLayout = document->documentLayout();
-	const auto collapsedCutoff = CollapsedQuoteCutoff(_st);
+	cache.revision = _paintGeometryRevision;
+	cache.width = width;
+	cache.size = size;
+	cache.quotes.clear();
+	cache.spoilers.clear();
+	cache.maxTopExtension = 0;
 
 	auto textSpoilerIt = begin(_spoilerRangesText);
 	const auto textSpoilerEnd = end(_spoilerRangesText);
@@ -2302,45 +2336,46 @@ void InputField::paintQuotes(QPaintEvent *e) {
 		emojiSpoilerAdjust(position, till);
 	};
 
-	_spoilerRects.resize(0);
+	auto &spoilers = cache.spoilers;
 	auto lineStart = 0;
 	const auto addSpoiler = [&](QRectF rect, bool blockquote) {
 		auto normal = rect.toRect();
-		if (lineStart < _spoilerRects.size()) {
-			auto &last = _spoilerRects.back();
+		if (lineStart < spoilers.size()) {
+			auto &last = spoilers.back();
 			if (last.geometry.intersects(normal)) {
 				Assert(last.blockquote == blockquote);
 				last.geometry = last.geometry.united(normal);
 				return;
 			}
 		}
-		_spoilerRects.push_back({ normal, blockquote });
+		spoilers.push_back({ normal, blockquote });
 	};
 	const auto finishSpoilersLine = [&] {
-		if (lineStart == _spoilerRects.size()) {
+		if (lineStart == spoilers.size()) {
 			return;
 		}
 		ranges::sort(
-			_spoilerRects.begin() + lineStart,
-			_spoilerRects.end(),
+			spoilers.begin() + lineStart,
+			spoilers.end(),
 			ranges::less(),
 			[](const SpoilerRect &r) { return r.geometry.x(); });
-		auto i = _spoilerRects.begin() + lineStart;
+		auto i = spoilers.begin() + lineStart;
 		auto j = i + 1;
-		while (j != end(_spoilerRects)) {
+		while (j != end(spoilers)) {
 			if (i->geometry.x() + i->geometry.width() >= j->geometry.x()) {
 				i->geometry = i->geometry.united(j->geometry);
-				j = _spoilerRects.erase(j);
+				j = spoilers.erase(j);
 			} else {
 				i = j++;
 			}
 		}
-		lineStart = int(_spoilerRects.size());
+		lineStart = int(spoilers.size());
 	};
 
-	auto block = document->firstBlock();
-	while (block.isValid()) {
-		auto belowClip = false;
+	auto maxBottom = std::numeric_limits<int>::min();
+	for (auto block = document->firstBlock()
+		; block.isValid()
+		; block = block.next()) {
 		auto blockRect = std::optional<QRectF>();
 		const auto ensureBlockRect = [&] {
 			if (!blockRect) {
@@ -2349,6 +2384,10 @@ void InputField::paintQuotes(QPaintEvent *e) {
 		};
 
 		const auto blockPosition = block.position();
+		if (blockPosition + block.length() > laidOut) {
+			// The rest is not laid out yet, see FieldDocumentLayout.
+			break;
+		}
 		const auto format = block.blockFormat();
 		const auto id = format.property(kQuoteFormatId).toString();
 		const auto blockquote = (id == kTagBlockquote);
@@ -2357,64 +2396,53 @@ void InputField::paintQuotes(QPaintEvent *e) {
 
 		spoilersAdjust(blockPosition, blockPosition + block.length());
 		if (textSpoiler || emojiSpoiler) {
-			ensureShift();
 			ensureBlockRect();
-			const auto fullShift = blockRect->topLeft() + *shift;
-			if (fullShift.y() >= clip.y() + clip.height()) {
-				belowClip = true;
-			} else if (fullShift.y() + blockRect->height() > clip.y()) {
-				const auto blockLayout = block.layout();
-				const auto lines = std::max(blockLayout->lineCount(), 0);
-				for (auto i = 0; i != lines; ++i) {
-					const auto line = blockLayout->lineAt(i);
-					const auto top = fullShift.y() + line.y();
-					const auto height = line.height();
-					if (top + height <= clip.y()) {
-						continue;
-					} else if (top >= clip.y() + clip.height()) {
-						belowClip = true;
-						break;
-					}
-					const auto lineFrom = blockPosition + line.textStart();
-					const auto lineTill = lineFrom + line.textLength();
-
-					textSpoilerAdjust(lineFrom, lineTill);
-					while (textSpoiler) {
-						const auto from = std::max(textSpoiler->from, lineFrom);
-						const auto runs = line.glyphRuns(
-							std::max(textSpoiler->from, lineFrom) - blockPosition,
-							std::min(textSpoiler->till, lineTill) - from);
-						for (const auto &run : runs) {
-							const auto runRect = run.boundingRect();
-							addSpoiler(
-								QRectF(
-									fullShift.x() + runRect.x(),
-									top,
-									runRect.width(),
-									height),
-								blockquote);
-						}
-						textSpoilerAdjust(textSpoiler->till, lineTill);
-					}
-
-					emojiSpoilerAdjust(lineFrom, lineTill);
-					while (emojiSpoiler) {
-						const auto from = std::max(emojiSpoiler->from, lineFrom);
-						const auto till = std::min(emojiSpoiler->till, lineTill);
-						const auto x = line.cursorToX(from - blockPosition);
-						const auto width = line.cursorToX(till - blockPosition) - x;
+			const auto fullShift = blockRect->topLeft();
+			const auto blockLayout = block.layout();
+			const auto lines = std::max(blockLayout->lineCount(), 0);
+			for (auto i = 0; i != lines; ++i) {
+				const auto line = blockLayout->lineAt(i);
+				const auto top = fullShift.y() + line.y();
+				const auto height = line.height();
+				const auto lineFrom = blockPosition + line.textStart();
+				const auto lineTill = lineFrom + line.textLength();
+
+				textSpoilerAdjust(lineFrom, lineTill);
+				while (textSpoiler) {
+					const auto from = std::max(textSpoiler->from, lineFrom);
+					const auto runs = line.glyphRuns(
+						std::max(textSpoiler->from, lineFrom) - blockPosition,
+						std::min(textSpoiler->till, lineTill) - from);
+					for (const auto &run : runs) {
+						const auto runRect = run.boundingRect();
 						addSpoiler(
 							QRectF(
-								fullShift.x() + std::min(x, x + width),
+								fullShift.x() + runRect.x(),
 								top,
-								std::abs(width),
+								runRect.width(),
 								height),
 							blockquote);
-						emojiSpoilerAdjust(emojiSpoiler->till, lineTill);
 					}
+					textSpoilerAdjust(textSpoiler->till, lineTill);
+				}
 
-					finishSpoilersLine();
+				emojiSpoilerAdjust(lineFrom, lineTill);
+				while (emojiSpoiler) {
+					const auto from = std::max(emojiSpoiler->from, lineFrom);
+					const auto till = std::min(emojiSpoiler->till, lineTill);
+					const auto x = line.cursorToX(from - blockPosition);
+					const auto width = line.cursorToX(till - blockPosition) - x;
+					addSpoiler(
+						QRectF(
+							fullShift.x() + std::min(x, x + width),
+							top,
+							std::abs(width),
+							height),
+						blockquote);
+					emojiSpoilerAdjust(emojiSpoiler->till, lineTill);
 				}
+
+				finishSpoilersLine();
 			}
 		}
 
@@ -2424,54 +2452,108 @@ void InputField::paintQuotes(QPaintEvent *e) {
 			? &_st.style.blockquote
 			: nullptr;
 		if (st) {
-			if (!shift) {
-				shift.emplace(
-					-_inner->horizontalScrollBar()->value(),
-					-_inner->verticalScrollBar()->value());
-			}
-			if (!blockRect) {
-				blockRect.emplace(documentLayout->blockBoundingRect(block));
-			}
+			ensureBlockRect();
 			const auto rect = blockRect->toRect();
 			const auto added = pre
 				? QMargins(0, 0, 0, st->verticalSkip)
 				: QMargins();
-			const auto target = ExtendForPaint(
-				rect.marginsAdded(added),
-				*st
-			).translated(*shift);
-			if (target.intersects(clip)) {
-				ensurePainter();
-				const auto cache = pre ? _preCache() : _blockquoteCache();
-				const auto collapsible = !pre
-					&& !collapsed
-					&& (rect.height() > collapsedCutoff);
-				Text::ValidateQuotePaintCache(*cache, *st);
-				Text::FillQuotePaint(*p, target, *cache, *st, {
-					.expandIcon = collapsed,
-					.collapseIcon = collapsible,
-				});
-				if (!pre) {
-					_blockquoteBg = cache->bg;
-				}
-
-				if (st->header > 0) {
-					const auto font = _st.style.font->monospace();
-					const auto topleft = target.topLeft();
-					const auto position = topleft + st->headerPosition;
-					const auto baseline = position + QPoint(0, font->ascent);
-					p->setFont(font);
-					p->setPen(st::defaultTextPalette.monoFg);
-					p->drawText(
-						baseline,
-						format.property(kPreLanguage).toString());
-				}
-			}
+			const auto target = ExtendForPaint(rect.marginsAdded(added), *st);
+			maxBottom = std::max(maxBottom, target.y() + target.height());
+			cache.maxTopExtension = std::max(
+				cache.maxTopExtension,
+				rect.y() - target.y());
+			cache.quotes.push_back({
+				.target = target,
+				.language = (st->header > 0)
+					? format.property(kPreLanguage).toString()
+					: QString(),
+				.top = rect.y(),
+				.maxBottom = maxBottom,
+				.height = rect.height(),
+				.pre = pre,
+				.collapsed = collapsed,
+			});
 		}
-		if (belowClip) {
+	}
+}
+
+void InputField::paintQuotes(QPaintEvent *e) {
+	if (!_blockquoteCache || !_preCache) {
+		return;
+	}
+	refreshPaintGeometry();
+
+	const auto clip = e->rect();
+	const auto shift = QPoint(
+		-_inner->horizontalScrollBar()->value(),
+		-_inner->verticalScrollBar()->value());
+
+	// Spoiler rects for the overlay are taken for the whole viewport,
+	// the overlay is repainted by its own animation with any clip.
+	const auto viewport = _inner->viewport()->rect().translated(-shift);
+	const auto &spoilers = _paintGeometry.spoilers;
+	_spoilerRects.clear();
+	for (auto i = ranges::upper_bound(
+			spoilers,
+			viewport.y() - 1,
+			ranges::less(),
+			[](const SpoilerRect &r) { return r.geometry.bottom(); })
+		; i != end(spoilers) && i->geometry.y() <= viewport.bottom()
+		; ++i) {
+		_spoilerRects.push_back({
+			i->geometry.translated(shift),
+			i->blockquote,
+		});
+	}
+
+	const auto &quotes = _paintGeometry.quotes;
+	if (quotes.empty()) {
+		return;
+	}
+	const auto local = clip.translated(-shift);
+	const auto clipBottom = local.y() + local.height();
+	const auto collapsedCutoff = CollapsedQuoteCutoff(_st);
+	auto p = std::optional<QPainter>();
+	for (auto i = ranges::upper_bound(
+			quotes,
+			local.y(),
+			ranges::less(),
+			&QuoteGeometry::maxBottom)
+		; i != end(quotes)
+		; ++i) {
+		if (i->top - _paintGeometry.maxTopExtension >= clipBottom) {
 			break;
 		}
-		block = block.next();
+		const auto target = i->target.translated(shift);
+		if (!target.intersects(clip)) {
+			continue;
+		} else if (!p) {
+			p.emplace(_inner->viewport());
+		}
+		const auto pre = i->pre;
+		const auto st = pre ? &_st.style.pre : &_st.style.blockquote;
+		const auto cache = pre ? _preCache() : _blockquoteCache();
+		const auto collapsible = !pre
+			&& !i->collapsed
+			&& (i->height > collapsedCutoff);
+		Text::ValidateQuotePaintCache(*cache, *st);
+		Text::FillQuotePaint(*p, target, *cache, *st, {
+			.expandIcon = i->collapsed,
+			.collapseIcon = collapsible,
+		});
+		if (!pre) {
+			_blockquoteBg = cache->bg;
+		}
+
+		if (st->header > 0) {
+			const auto font = _st.style.font->monospace();
+			const auto topleft = target.topLeft();
+			const auto position = topleft + st->headerPosition;
+			const auto baseline = position + QPoint(0, font->ascent);
+			p->setFont(font);
+			p->setPen(st::defaultTextPalette.monoFg);
+			p->drawText(baseline, i->language);
+		}
 	}
 }
 
@@ -2643,7 +2725,8 @@ bool InputField::heightAutoupdated() {
 
 	SendPendingMoveResizeEvents(this);
 
-	const auto contentHeight = int(std::ceil(document()->size().height()))
+	const auto documentHeight = _documentLayout->estimatedSize().height();
+	const auto contentHeight = int(std::ceil(documentHeight))
 		+ _st.textMargins.top()
 		+ _st.textMargins.bottom()
 		+ _additionalMargins.top()
@@ -2993,10 +3076,14 @@ int InputField::lookupActionQuoteId(QPoint point) const {
 
 	const auto document = _inner->document();
 	const auto layout = document->documentLayout();
+	const auto laidOut = _documentLayout->laidOutPosition();
 	const auto collapsedCutoff = CollapsedQuoteCutoff(_st);
 	auto block = document->firstBlock();
 
 	while (block.isValid()) {
+		if (block.position() + block.length() > laidOut) {
+			break;
+		}
 		const auto format = block.blockFormat();
 		const auto id = format.property(kQuoteFormatId).toString();
 		const auto collapsed = (id == kTagBlockquoteCollapsed);
@@ -3505,6 +3592,13 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 
 				auto *ch = textStart + qMax(changedPositionInFragment, 0);
 				for (; ch < textEnd; ++ch) {
+					if (_mode == Mode::MultiLine && !breakTagOnNotLetter) {
+						// Nothing else to check till a possible emoji.
+						ch = Emoji::SkipToPossibleEmoji(ch, textEnd);
+						if (ch == textEnd) {
+							break;
+						}
+					}
 					const auto removeNewline = (_mode != Mode::MultiLine)
 						&& IsNewline(*ch);
 					if (removeNewline) {
@@ -3877,6 +3971,7 @@ void InputField::handleContentsChanged() {
 		_markdownEnabledState.disabled() ? nullptr : &_lastMarkdownTags);
 
 	//highlightMarkdown();
+	++_paintGeometryRevision;
 	if (_spoilerRangesText.empty() && _spoilerRangesEmoji.empty()) {
 		_spoilerOverlay = nullptr;
 	} else if (_customObject) {
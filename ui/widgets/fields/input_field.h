@@ -83,6 +83,7 @@ enum class MarkdownSet {
 };
 
 class CustomFieldObject;
+class FieldDocumentLayout;
 
 struct MarkdownEnabled {
 	base::flat_set<QString> tagsSubset;
@@ -429,6 +430,24 @@ private:
 	friend class FieldSpoilerOverlay;
 	using TextRange = InputFieldTextRange;
 	using SpoilerRect = InputFieldSpoilerRect;
+	struct QuoteGeometry {
+		QRect target;
+		QString language;
+		int top = 0;
+		int maxBottom = 0;
+		int height = 0;
+		bool pre = false;
+		bool collapsed = false;
+	};
+	// Quote and spoiler geometry in document coordinates.
+	struct PaintGeometry {
+		std::vector<QuoteGeometry> quotes;
+		std::vector<SpoilerRect> spoilers;
+		QSizeF size;
+		int maxTopExtension = 0;
+		int revision = -1;
+		int width = 0;
+	};
 	enum class MarkdownActionType {
 		ToggleTag,
 		EditLink,
@@ -468,6 +487,7 @@ private:
 	void inputMethodEventInner(QInputMethodEvent *e);
 	void paintEventInner(QPaintEvent *e);
 	void paintQuotes(QPaintEvent *e);
+	void refreshPaintGeometry();
 
 	void mousePressEventInner(QMouseEvent *e);
 	void mouseReleaseEventInner(QMouseEvent *e);
@@ -583,6 +603,7 @@ private:
 		float64 errorDegree,
 		float64 focusedDegree);
 	void customEmojiRepaint();
+	[[nodiscard]] QPoint documentOffset() const;
 	void highlightMarkdown();
 	bool exitQuoteWithNewBlock(int key);
 
@@ -620,6 +641,8 @@ private:
 	mutable std::vector<TextRange> _spoilerRangesEmoji;
 	mutable std::vector<SpoilerRect> _spoilerRects;
 	mutable QColor _blockquoteBg;
+	PaintGeometry _paintGeometry;
+	int _paintGeometryRevision = 0;
 	std::unique_ptr<RpWidget> _spoilerOverlay;
 
 	QMargins _additionalMargins;
@@ -648,6 +671,7 @@ private:
 
 	Fn<QString(QStringView)> _tagMimeProcessor;
 	std::unique_ptr<CustomFieldObject> _customObject;
+	FieldDocumentLayout *_documentLayout = nullptr;
 	std::optional<QTextCursor> _formattingCursorUpdate;
 
 	SubmitSettings _submitSettings = SubmitSettings::Enter;
@@ -60,14 +60,30 @@ CrossFadeAnimation::CrossFadeAnimation(
 	};
 	fillDataTill(was);
 	fillDataTill(now);
-	auto preparePart = [](const Data &data, int index, const Data &other) {
+
+	// All lines of a label share one pixmap, each line is a source rect.
+	const auto pixelRatio = style::DevicePixelRatio();
+	const auto prepareSnapshot = [&](Data &data) {
+		if (data.full.isNull()) {
+			return QPixmap();
+		}
+		auto result = PixmapFromImage(std::move(data.full));
+		result.setDevicePixelRatio(pixelRatio);
+		return result;
+	};
+	const auto snapshotWas = prepareSnapshot(was);
+	const auto snapshotNow = prepareSnapshot(now);
+	auto preparePart = [&](
+			const Data &data,
+			const QPixmap &snapshot,
+			int index,
+			const Data &other) {
 		auto result = CrossFadeAnimation::Part();
 		auto lineWidth = data.lineWidths[index];
 		if (lineWidth < 0) {
 			lineWidth = other.lineWidths[index];
 		}
-		const auto pixelRatio = style::DevicePixelRatio();
-		auto fullWidth = data.full.width() / pixelRatio;
+		auto fullWidth = snapshot.width() / pixelRatio;
 		auto top = index * data.lineHeight + data.lineAddTop;
 		auto left = 0;
 		if (data.align & Qt::AlignHCenter) {
@@ -75,16 +91,18 @@ CrossFadeAnimation::CrossFadeAnimation(
 		} else if (data.align & Qt::AlignRight) {
 			left += (fullWidth - lineWidth);
 		}
-		auto snapshotRect = data.full.rect().intersected(QRect(left * pixelRatio, top * pixelRatio, lineWidth * pixelRatio, data.font->height * pixelRatio));
+		auto snapshotRect = snapshot.rect().intersected(QRect(left * pixelRatio, top * pixelRatio, lineWidth * pixelRatio, data.font->height * pixelRatio));
 		if (!snapshotRect.isEmpty()) {
-			result.snapshot = PixmapFromImage(data.full.copy(snapshotRect));
-			result.snapshot.setDevicePixelRatio(pixelRatio);
+			result.snapshot = snapshot;
+			result.source = snapshotRect;
 		}
 		result.position = data.position + QPoint(data.margin.left() + left, data.margin.top() + top);
 		return result;
 	};
 	for (int i = 0; i != maxLines; ++i) {
-		addLine(preparePart(was, i, now), preparePart(now, i, was));
+		addLine(
+			preparePart(was, snapshotWas, i, now),
+			preparePart(now, snapshotNow, i, was));
 	}
 }
 
@@ -124,34 +142,40 @@ void CrossFadeAnimation::paintLine(
 		return;
 	}
 
+	const auto source = [](const Part &part) {
+		return part.source.isEmpty() ? part.snapshot.rect() : part.source;
+	};
+	const auto sourceWas = source(line.was);
+	const auto sourceNow = source(line.now);
+
 	const auto pixelRatio = style::DevicePixelRatio();
 	auto positionWas = line.was.position;
 	auto positionNow = line.now.position;
 	auto left = anim::interpolate(positionWas.x(), positionNow.x(), positionReady);
-	auto topDelta = (snapshotNow.height() / pixelRatio) - (snapshotWas.height() / pixelRatio);
-	auto widthDelta = (snapshotNow.width() / pixelRatio) - (snapshotWas.width() / pixelRatio);
+	auto topDelta = (sourceNow.height() / pixelRatio) - (sourceWas.height() / pixelRatio);
+	auto widthDelta = (sourceNow.width() / pixelRatio) - (sourceWas.width() / pixelRatio);
 	auto topWas = anim::interpolate(positionWas.y(), positionNow.y() + topDelta, positionReady);
 	auto topNow = topWas - topDelta;
 
 	p.setOpacity(alphaWas);
 	if (!snapshotWas.isNull()) {
-		p.drawPixmap(left, topWas, snapshotWas);
+		p.drawPixmap(QPoint(left, topWas), snapshotWas, sourceWas);
 		if (topDelta > 0) {
-			p.fillRect(left, topWas - topDelta, snapshotWas.width() / pixelRatio, topDelta, _bg);
+			p.fillRect(left, topWas - topDelta, sourceWas.width() / pixelRatio, topDelta, _bg);
 		}
 		if (widthDelta > 0) {
-			p.fillRect(left + (snapshotWas.width() / pixelRatio), topNow, widthDelta, snapshotNow.height() / pixelRatio, _bg);
+			p.fillRect(left + (sourceWas.width() / pixelRatio), topNow, widthDelta, sourceNow.height() / pixelRatio, _bg);
 		}
 	}
 
 	p.setOpacity(alphaNow);
 	if (!snapshotNow.isNull()) {
-		p.drawPixmap(left, topNow, snapshotNow);
+		p.drawPixmap(QPoint(left, topNow), snapshotNow, sourceNow);
 		if (topDelta < 0) {
-			p.fillRect(left, topNow + topDelta, snapshotNow.width() / pixelRatio, -topDelta, _bg);
+			p.fillRect(left, topNow + topDelta, sourceNow.width() / pixelRatio, -topDelta, _bg);
 		}
 		if (widthDelta < 0) {
-			p.fillRect(left + (snapshotNow.width() / pixelRatio), topWas, -widthDelta, snapshotWas.height() / pixelRatio, _bg);
+			p.fillRect(left + (sourceNow.width() / pixelRatio), topWas, -widthDelta, sourceWas.height() / pixelRatio, _bg);
 		}
 	}
 }
@@ -902,7 +926,19 @@ CrossFadeAnimation::Data FlatLabel::crossFadeData(
 		style::color bg,
 		QPoint basePosition) {
 	auto result = CrossFadeAnimation::Data();
-	result.full = GrabWidgetToImage(this, QRect(), bg->c);
+	if (!size().isEmpty()) {
+		// Render the text directly, without going through QWidget::render.
+		const auto ratio = style::DevicePixelRatio();
+		result.full = QImage(
+			size() * ratio,
+			QImage::Format_ARGB32_Premultiplied);
+		result.full.setDevicePixelRatio(ratio);
+		result.full.fill(bg->c);
+		if (_opacity > 0.) {
+			auto p = Painter(&result.full);
+			paintContent(p, rect());
+		}
+	}
 	const auto textWidth = width() - _st.margin.left() - _st.margin.right();
 	result.lineWidths = _text.countLineWidths(textWidth, {
 		.breakEverywhere = _breakEverywhere,
@@ -1071,6 +1107,10 @@ void FlatLabel::paintEvent(QPaintEvent *e) {
 	}
 
 	Painter p(this);
+	paintContent(p, e->rect());
+}
+
+void FlatLabel::paintContent(Painter &p, QRect clip) {
 	p.setOpacity(_opacity);
 	if (_textColorOverride) {
 		p.setPen(*_textColorOverride);
@@ -1110,7 +1150,7 @@ void FlatLabel::paintEvent(QPaintEvent *e) {
 		.position = { textLeft, _st.margin.top() },
 		.availableWidth = textWidth,
 		.align = _st.align,
-		.clip = e->rect(),
+		.clip = clip,
 		.palette = &_st.palette,
 		.pre = _preCacheCallback ? _preCacheCallback().get() : nullptr,
 		.blockquote = (_blockquoteCacheCallback
@@ -39,6 +39,7 @@ public:
 
 	struct Part {
 		QPixmap snapshot;
+		QRect source; // In snapshot pixels, whole snapshot if empty.
 		QPoint position;
 	};
 	void addLine(Part was, Part now);
@@ -242,6 +243,8 @@ private:
 	Text::StateResult getTextState(const QPoint &m) const;
 	void refreshCursor(bool uponSymbol);
 
+	void paintContent(Painter &p, QRect clip);
+
 	int countTextWidth(int newWidth) const;
 	int countTextHeight(int textWidth);
 	void refreshSize();
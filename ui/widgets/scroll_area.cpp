@@ -67,10 +67,165 @@ base::options::toggle OptionQScroller({
 	return scToFrom;
 }
 
+// Touch fling slows down linearly, pixels per second each second.
+constexpr auto kTouchFlingDeceleration = 1000.;
+
+// Only the latest finger movement defines the fling velocity.
+constexpr auto kTouchVelocityWindow = crl::time(100);
+
+// Fingers are inaccurate, we ignore small speeds on each axis to avoid
+// stopping the autoscroll because of a small horizontal offset
+// when scrolling vertically, 3px per second.
+constexpr auto kTouchMinAxisVelocity = 3.;
+
+// While a finger moves during a fling, the fling velocity is a quarter
+// of its previous value and three quarters of the finger velocity.
+constexpr auto kTouchFollowPart = 0.75;
+
+[[nodiscard]] float64 FlingDistance(float64 velocity, float64 seconds) {
+	const auto speed = std::abs(velocity);
+	const auto time = std::min(seconds, speed / kTouchFlingDeceleration);
+	const auto result = speed * time
+		- kTouchFlingDeceleration * time * time / 2.;
+	return (velocity < 0.) ? -result : result;
+}
+
+[[nodiscard]] float64 FlingVelocity(float64 velocity, float64 seconds) {
+	const auto speed = std::max(
+		std::abs(velocity) - kTouchFlingDeceleration * seconds,
+		0.);
+	return (velocity < 0.) ? -speed : speed;
+}
+
+[[nodiscard]] float64 FilterAxisVelocity(float64 velocity) {
+	return (std::abs(velocity) > kTouchMinAxisVelocity) ? velocity : 0.;
+}
+
 } // namespace
 
 const char kOptionQScroller[] = "qscroller";
 
+void TouchFling::addSample(QPoint position, crl::time now) {
+	_samples[_samplesNext] = { position, now };
+	_samplesNext = (_samplesNext + 1) % kMaxSamples;
+	_samplesCount = std::min(_samplesCount + 1, kMaxSamples);
+}
+
+void TouchFling::clearSamples() {
+	_samplesCount = _samplesNext = 0;
+}
+
+QPointF TouchFling::estimateVelocity(crl::time now) const {
+	// Least squares fit of the recent positions by time.
+	auto count = 0;
+	auto sumTime = 0.;
+	auto sumPosition = QPointF();
+	const auto recent = [&](const Sample &sample) {
+		return (now - sample.time <= kTouchVelocityWindow);
+	};
+	for (auto i = 0; i != _samplesCount; ++i) {
+		if (recent(_samples[i])) {
+			++count;
+			sumTime += _samples[i].time;
+			sumPosition += _samples[i].position;
+		}
+	}
+	if (count < 2) {
+		return QPointF();
+	}
+	const auto meanTime = sumTime / count;
+	const auto meanPosition = sumPosition / count;
+	auto squares = 0.;
+	auto products = QPointF();
+	for (auto i = 0; i != _samplesCount; ++i) {
+		if (recent(_samples[i])) {
+			const auto time = _samples[i].time - meanTime;
+			squares += time * time;
+			products += (_samples[i].position - meanPosition) * time;
+		}
+	}
+	if (!squares) {
+		return QPointF();
+	}
+	const auto perSecond = products * 1000. / squares;
+	return {
+		FilterAxisVelocity(perSecond.x()),
+		FilterAxisVelocity(perSecond.y()),
+	};
+}
+
+void TouchFling::start(QPointF velocity, crl::time now) {
+	const auto limit = float64(kMaxScrollFlick);
+	launch({
+		std::clamp(velocity.x(), -limit, limit),
+		std::clamp(velocity.y(), -limit, limit),
+	}, now);
+}
+
+void TouchFling::follow(QPointF velocity, crl::time now) {
+	const auto current = this->velocity(now);
+	if (current.isNull()) {
+		start(velocity, now);
+		return;
+	}
+	const auto limit = float64(kMaxScrollFlick);
+	const auto blend = [&](float64 was, float64 finger) {
+		return std::clamp(
+			FilterAxisVelocity(
+				was * (1. - kTouchFollowPart) + finger * kTouchFollowPart),
+			-limit,
+			limit);
+	};
+	launch({
+		blend(current.x(), velocity.x()),
+		blend(current.y(), velocity.y()),
+	}, now);
+}
+
+void TouchFling::launch(QPointF velocity, crl::time now) {
+	_initial = velocity;
+	_travelled = QPoint();
+	_started = now;
+	_duration = std::max(std::abs(velocity.x()), std::abs(velocity.y()))
+		/ kTouchFlingDeceleration;
+	_active = (_duration > 0.);
+}
+
+void TouchFling::stop() {
+	_active = false;
+}
+
+bool TouchFling::active() const {
+	return _active;
+}
+
+QPointF TouchFling::velocity(crl::time now) const {
+	if (!_active) {
+		return QPointF();
+	}
+	const auto seconds = std::max(now - _started, crl::time(0)) / 1000.;
+	return {
+		FlingVelocity(_initial.x(), seconds),
+		FlingVelocity(_initial.y(), seconds),
+	};
+}
+
+QPoint TouchFling::advance(crl::time now) {
+	if (!_active) {
+		return QPoint();
+	}
+	const auto seconds = std::max(now - _started, crl::time(0)) / 1000.;
+	const auto travelled = QPoint(
+		int(FlingDistance(_initial.x(), seconds)),
+		int(FlingDistance(_initial.y(), seconds)));
+	const auto result = travelled - _travelled;
+	_travelled = travelled;
+	if (seconds >= _duration) {
+		_active = false;
+	}
+	return result;
+}
+
 void SetupScrollerPhysics(not_null<QScroller*> scroller, bool ownsOvershoot) {
 	auto props = scroller->scrollerProperties();
 	using P = QScrollerProperties;
@@ -524,7 +679,9 @@ ScrollArea::ScrollArea(
 	if (_touchEnabled) {
 		viewport()->setAttribute(Qt::WA_AcceptTouchEvents);
 		_touchTimer.setCallback([=] { _touchRightButton = true; });
-		_touchScrollTimer.setCallback([=] { touchScrollTimer(); });
+		_touchScrollAnimation.init([=](crl::time now) {
+			return touchScrollFrame(now);
+		});
 	}
 
 	rpl::single(
@@ -557,13 +714,6 @@ ScrollArea::ScrollArea(
 	}, lifetime());
 }
 
-void ScrollArea::touchDeaccelerate(int32 elapsed) {
-	int32 x = _touchSpeed.x();
-	int32 y = _touchSpeed.y();
-	_touchSpeed.setX((x == 0) ? x : (x > 0) ? qMax(0, x - elapsed) : qMin(0, x + elapsed));
-	_touchSpeed.setY((y == 0) ? y : (y > 0) ? qMax(0, y - elapsed) : qMin(0, y + elapsed));
-}
-
 void ScrollArea::setOverscrollEdges(
 		Fn<bool()> allowTop,
 		Fn<bool()> allowBottom) {
@@ -672,69 +822,31 @@ int ScrollArea::scrollTop() const {
 	return _verticalValue;
 }
 
-void ScrollArea::touchScrollTimer() {
-	auto nowTime = crl::now();
-	if (_touchScrollState == TouchScrollState::Acceleration && _touchWaitingAcceleration && (nowTime - _touchAccelerationTime) > 40) {
+bool ScrollArea::touchScrollFrame(crl::time now) {
+	if (_touchScrollState == TouchScrollState::Acceleration
+		&& _touchWaitingAcceleration
+		&& (now - _touchAccelerationTime) > kTouchAccelerationTimeout) {
 		_touchScrollState = TouchScrollState::Manual;
-		touchResetSpeed();
-	} else if (_touchScrollState == TouchScrollState::Auto || _touchScrollState == TouchScrollState::Acceleration) {
-		int32 elapsed = int32(nowTime - _touchTime);
-		QPoint delta = _touchSpeed * elapsed / 1000;
-		bool hasScrolled = touchScroll(delta);
-
-		if (_touchSpeed.isNull() || !hasScrolled) {
-			_touchScrollState = TouchScrollState::Manual;
-			_touchScroll = false;
-			_touchScrollTimer.cancel();
-		} else {
-			_touchTime = nowTime;
-		}
-		touchDeaccelerate(elapsed);
+		_touchFling.stop();
+		return false;
+	} else if (_touchScrollState == TouchScrollState::Manual) {
+		_touchFling.stop();
+		return false;
 	}
-}
-
-void ScrollArea::touchUpdateSpeed() {
-	const auto nowTime = crl::now();
-	if (_touchPrevPosValid) {
-		const int elapsed = nowTime - _touchSpeedTime;
-		if (elapsed) {
-			const QPoint newPixelDiff = (_touchPos - _touchPrevPos);
-			const QPoint pixelsPerSecond = newPixelDiff * (1000 / elapsed);
-
-			// fingers are inacurates, we ignore small changes to avoid stopping the autoscroll because
-			// of a small horizontal offset when scrolling vertically
-			const int newSpeedY = (qAbs(pixelsPerSecond.y()) > kFingerAccuracyThreshold) ? pixelsPerSecond.y() : 0;
-			const int newSpeedX = (qAbs(pixelsPerSecond.x()) > kFingerAccuracyThreshold) ? pixelsPerSecond.x() : 0;
-			if (_touchScrollState == TouchScrollState::Auto) {
-				const int oldSpeedY = _touchSpeed.y();
-				const int oldSpeedX = _touchSpeed.x();
-				if ((oldSpeedY <= 0 && newSpeedY <= 0) || ((oldSpeedY >= 0 && newSpeedY >= 0)
-					&& (oldSpeedX <= 0 && newSpeedX <= 0)) || (oldSpeedX >= 0 && newSpeedX >= 0)) {
-					_touchSpeed.setY(std::clamp((oldSpeedY + (newSpeedY / 4)), -kMaxScrollAccelerated, +kMaxScrollAccelerated));
-					_touchSpeed.setX(std::clamp((oldSpeedX + (newSpeedX / 4)), -kMaxScrollAccelerated, +kMaxScrollAccelerated));
-				} else {
-					_touchSpeed = QPoint();
-				}
-			} else {
-				// we average the speed to avoid strange effects with the last delta
-				if (!_touchSpeed.isNull()) {
-					_touchSpeed.setX(std::clamp((_touchSpeed.x() / 4) + (newSpeedX * 3 / 4), -kMaxScrollFlick, +kMaxScrollFlick));
-					_touchSpeed.setY(std::clamp((_touchSpeed.y() / 4) + (newSpeedY * 3 / 4), -kMaxScrollFlick, +kMaxScrollFlick));
-				} else {
-					_touchSpeed = QPoint(newSpeedX, newSpeedY);
-				}
-			}
-		}
-	} else {
-		_touchPrevPosValid = true;
+	const auto delta = _touchFling.advance(now);
+	const auto hasScrolled = delta.isNull() || touchScroll(delta);
+	if (!_touchFling.active() || !hasScrolled) {
+		_touchFling.stop();
+		_touchScrollState = TouchScrollState::Manual;
+		_touchScroll = false;
+		return false;
 	}
-	_touchSpeedTime = nowTime;
-	_touchPrevPos = _touchPos;
+	return true;
 }
 
-void ScrollArea::touchResetSpeed() {
-	_touchSpeed = QPoint();
-	_touchPrevPosValid = false;
+void ScrollArea::touchScrollStop() {
+	_touchFling.stop();
+	_touchScrollAnimation.stop();
 }
 
 bool ScrollArea::eventHook(QEvent *e) {
@@ -859,6 +971,7 @@ bool ScrollArea::filterOutTouchEvent(QEvent *e) {
 }
 
 void ScrollArea::touchEvent(QTouchEvent *e) {
+	const auto now = crl::now();
 	if (!e->touchPoints().isEmpty()) {
 		_touchPrevPos = _touchPos;
 		_touchPos = e->touchPoints().cbegin()->screenPos().toPoint();
@@ -868,13 +981,13 @@ void ScrollArea::touchEvent(QTouchEvent *e) {
 	case QEvent::TouchBegin: {
 		if (_touchPress || e->touchPoints().isEmpty()) return;
 		_touchPress = true;
+		_touchFling.clearSamples();
+		_touchFling.addSample(_touchPos, now);
 		if (_touchScrollState == TouchScrollState::Auto) {
 			_touchScrollState = TouchScrollState::Acceleration;
 			_touchWaitingAcceleration = true;
 			_touchMaybePressing = false;
-			_touchAccelerationTime = crl::now();
-			touchUpdateSpeed();
-			_touchStart = _touchPos;
+			_touchAccelerationTime = now;
 		} else {
 			_touchScroll = false;
 			_touchMaybePressing = true;
@@ -886,19 +999,19 @@ void ScrollArea::touchEvent(QTouchEvent *e) {
 
 	case QEvent::TouchUpdate: {
 		if (!_touchPress) return;
+		_touchFling.addSample(_touchPos, now);
 		if (!_touchScroll && (_touchPos - _touchStart).manhattanLength() >= QApplication::startDragDistance()) {
 			_touchTimer.cancel();
 			_touchScroll = true;
 			_touchMaybePressing = false;
-			touchUpdateSpeed();
 		}
 		if (_touchScroll) {
 			if (_touchScrollState == TouchScrollState::Manual) {
 				touchScrollUpdated(_touchPos);
 			} else if (_touchScrollState == TouchScrollState::Acceleration) {
-				touchUpdateSpeed();
-				_touchAccelerationTime = crl::now();
-				if (_touchSpeed.isNull()) {
+				_touchAccelerationTime = now;
+				_touchFling.follow(_touchFling.estimateVelocity(now), now);
+				if (!_touchFling.active()) {
 					_touchScrollState = TouchScrollState::Manual;
 				}
 			}
@@ -911,18 +1024,20 @@ void ScrollArea::touchEvent(QTouchEvent *e) {
 		auto weak = base::make_weak(this);
 		if (_touchScroll) {
 			if (_touchScrollState == TouchScrollState::Manual) {
-				_touchScrollState = TouchScrollState::Auto;
-				_touchPrevPosValid = false;
-				_touchScrollTimer.callEach(15);
-				_touchTime = crl::now();
+				_touchFling.start(_touchFling.estimateVelocity(now), now);
+				if (_touchFling.active()) {
+					_touchScrollState = TouchScrollState::Auto;
+					_touchScrollAnimation.start();
+				} else {
+					_touchScroll = false;
+				}
 			} else if (_touchScrollState == TouchScrollState::Auto) {
 				_touchScrollState = TouchScrollState::Manual;
 				_touchScroll = false;
-				touchResetSpeed();
+				touchScrollStop();
 			} else if (_touchScrollState == TouchScrollState::Acceleration) {
 				_touchScrollState = TouchScrollState::Auto;
 				_touchWaitingAcceleration = false;
-				_touchPrevPosValid = false;
 			}
 		} else if (window()) { // one short tap -- like left mouse click, one long tap -- like right mouse click
 			Qt::MouseButton btn(_touchRightButton ? Qt::RightButton : Qt::LeftButton);
@@ -952,6 +1067,7 @@ void ScrollArea::touchEvent(QTouchEvent *e) {
 		_touchMaybePressing = false;
 		_touchScrollState = TouchScrollState::Manual;
 		_touchTimer.cancel();
+		touchScrollStop();
 	} break;
 	}
 }
@@ -959,7 +1075,6 @@ void ScrollArea::touchEvent(QTouchEvent *e) {
 void ScrollArea::touchScrollUpdated(const QPoint &screenPos) {
 	_touchPos = screenPos;
 	touchScroll(_touchPos - _touchPrevPos);
-	touchUpdateSpeed();
 }
 
 void ScrollArea::disableScroll(bool dis) {
@@ -1101,7 +1216,9 @@ void ScrollArea::doSetOwnedWidget(object_ptr<QWidget> w) {
 	}
 	_widget = std::move(w);
 	QScrollArea::setWidget(_widget);
+	_widgetPendingTracking.destroy();
 	if (_widget) {
+		_widgetPendingTracking = TrackPendingMoveResizeEvents(_widget.data());
 		_widget->setAutoFillBackground(false);
 		if (_touchEnabled) {
 			_widget->installEventFilter(this);
@@ -1113,6 +1230,7 @@ void ScrollArea::doSetOwnedWidget(object_ptr<QWidget> w) {
 
 object_ptr<QWidget> ScrollArea::doTakeWidget() {
 	QScrollArea::takeWidget();
+	_widgetPendingTracking.destroy();
 	return std::move(_widget);
 }
 
@@ -21,9 +21,6 @@ class QScroller;
 
 namespace Ui {
 
-// Touch flick ignore 3px.
-inline constexpr auto kFingerAccuracyThreshold = 3;
-
 // 4000px per second.
 inline constexpr auto kMaxScrollAccelerated = 4000;
 
@@ -36,6 +33,53 @@ enum class TouchScrollState {
 	Acceleration // Scrolling automatically but a finger is on the screen
 };
 
+// Hold the finger still that long to stop the fling.
+inline constexpr auto kTouchAccelerationTimeout = crl::time(40);
+
+// Kinetic scrolling after a touch flick, independent from any timer.
+// The velocity is estimated from timestamped finger positions and the
+// travelled distance is a function of the time passed since the start,
+// so the result doesn't depend on how often advance() is called.
+class TouchFling final {
+public:
+	void addSample(QPoint position, crl::time now);
+	void clearSamples();
+	[[nodiscard]] QPointF estimateVelocity(crl::time now) const;
+
+	void start(QPointF velocity, crl::time now);
+
+	// Folds the finger velocity into the running fling while the finger
+	// moves during it, the fling stops when the result is zero.
+	void follow(QPointF velocity, crl::time now);
+	void stop();
+
+	[[nodiscard]] bool active() const;
+	[[nodiscard]] QPointF velocity(crl::time now) const;
+
+	// Whole pixels travelled since the previous call.
+	[[nodiscard]] QPoint advance(crl::time now);
+
+private:
+	struct Sample {
+		QPoint position;
+		crl::time time = 0;
+	};
+	static constexpr auto kMaxSamples = 8;
+
+	void launch(QPointF velocity, crl::time now);
+
+	std::array<Sample, kMaxSamples> _samples;
+	int _samplesCount = 0;
+	int _samplesNext = 0;
+
+	QPointF _initial;
+	QPoint _travelled;
+	crl::time _started = 0;
+	float64 _duration = 0.;
+	bool _active = false;
+
+};
+
 class ScrollArea;
 
 struct ScrollToRequest {
@@ -270,13 +314,10 @@ private:
 	object_ptr<QWidget> doTakeWidget();
 
 	bool filterOutTouchEvent(QEvent *e);
-	void touchScrollTimer();
+	bool touchScrollFrame(crl::time now);
 	bool touchScroll(const QPoint &delta);
 	void touchScrollUpdated(const QPoint &screenPos);
-
-	void touchResetSpeed();
-	void touchUpdateSpeed();
-	void touchDeaccelerate(int32 elapsed);
+	void touchScrollStop();
 
 	void updateOverscrollByDirection(int wheelDeltaY);
 	void applyOverscrollAllowed(bool allowed);
@@ -305,14 +346,11 @@ private:
 	QPoint _touchStart, _touchPrevPos, _touchPos;
 
 	TouchScrollState _touchScrollState = TouchScrollState::Manual;
-	bool _touchPrevPosValid = false;
 	bool _touchWaitingAcceleration = false;
 	rpl::variable<bool> _touchMaybePressing;
-	QPoint _touchSpeed;
-	crl::time _touchSpeedTime = 0;
 	crl::time _touchAccelerationTime = 0;
-	crl::time _touchTime = 0;
-	base::Timer _touchScrollTimer;
+	TouchFling _touchFling;
+	Animations::Basic _touchScrollAnimation;
 
 	Fn<bool(not_null<QWheelEvent*>)> _customWheelProcess;
 	Fn<bool(not_null<QTouchEvent*>)> _customTouchProcess;
@@ -322,6 +360,7 @@ private:
 	bool _widgetAcceptsTouch = false;
 
 	object_ptr<QWidget> _widget = { nullptr };
+	rpl::lifetime _widgetPendingTracking;
 
 	rpl::event_stream<int> _scrollTopUpdated;
 	rpl::event_stream<> _scrolls;
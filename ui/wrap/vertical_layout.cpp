@@ -8,8 +8,6 @@
 
 #include "ui/ui_utility.h"
 
-#include <QAccessible>
-
 namespace Ui {
 
 QMargins VerticalLayout::getMargins() const {
@@ -59,8 +57,7 @@ void VerticalLayout::reorderRows(int oldIndex, int newIndex) {
 	// subclass that exposes an accessibility role (so a custom accessible
 	// interface is built for it) reports children in visual order via
 	// accessibilityChildWidgets(); see Window::TabListLayout.
-	auto event = QAccessibleEvent(this, QAccessible::ObjectReorder);
-	QAccessible::updateAccessibility(&event);
+	accessibilityChildrenReordered();
 }
 
 int VerticalLayout::resizeGetHeight(int newWidth) {
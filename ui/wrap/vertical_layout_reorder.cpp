@@ -18,6 +18,11 @@ namespace {
 
 constexpr auto kScrollFactor = 0.05;
 
+// Scroll deltas are computed for 60 frames per second
+// and integrated by the elapsed time of each animation frame.
+constexpr auto kScrollFramesPerSecond = 60.;
+constexpr auto kMaxScrollFrameDuration = crl::time(100);
+
 } // namespace
 
 VerticalLayoutReorder::VerticalLayoutReorder(
@@ -25,7 +30,7 @@ VerticalLayoutReorder::VerticalLayoutReorder(
 	not_null<ScrollArea*> scroll)
 : _layout(layout)
 , _scroll(scroll)
-, _scrollAnimation([=] { updateScrollCallback(); }) {
+, _scrollAnimation([=](crl::time now) { updateScrollCallback(now); }) {
 }
 
 VerticalLayoutReorder::VerticalLayoutReorder(not_null<VerticalLayout*> layout)
@@ -320,11 +325,24 @@ auto VerticalLayoutReorder::updates() const -> rpl::producer<Single> {
 	return _updates.events();
 }
 
-void VerticalLayoutReorder::updateScrollCallback() {
+void VerticalLayoutReorder::updateScrollCallback(crl::time now) {
 	if (!_scroll) {
 		return;
 	}
-	const auto delta = deltaFromEdge();
+	const auto elapsed = std::clamp(
+		now - _scrollLastTime,
+		crl::time(0),
+		kMaxScrollFrameDuration);
+	_scrollLastTime = now;
+	_scrollAccumulated += deltaFromEdge()
+		* kScrollFramesPerSecond
+		* elapsed
+		/ 1000.;
+	const auto delta = int(_scrollAccumulated);
+	if (!delta) {
+		return;
+	}
+	_scrollAccumulated -= delta;
 	const auto oldTop = _scroll->scrollTop();
 	_scroll->scrollToY(oldTop + delta);
 	const auto newTop = _scroll->scrollTop();
@@ -339,6 +357,8 @@ void VerticalLayoutReorder::checkForScrollAnimation() {
 	if (!_scroll || !deltaFromEdge() || _scrollAnimation.animating()) {
 		return;
 	}
+	_scrollLastTime = crl::now();
+	_scrollAccumulated = 0.;
 	_scrollAnimation.start();
 }
 
@@ -74,7 +74,7 @@ private:
 	void moveToShift(int index, int shift);
 	void updateShift(not_null<RpWidget*> widget, int indexHint);
 
-	void updateScrollCallback();
+	void updateScrollCallback(crl::time now);
 	void checkForScrollAnimation();
 	[[nodiscard]] int deltaFromEdge();
 
@@ -84,6 +84,8 @@ private:
 	Ui::ScrollArea *_scroll = nullptr;
 
 	Ui::Animations::Basic _scrollAnimation;
+	crl::time _scrollLastTime = 0;
+	float64 _scrollAccumulated = 0.;
 
 	std::vector<Interval> _pinnedIntervals;
 